@@ -5,8 +5,10 @@
 #include <vulkan/vulkan.h>
 #include "dependencies/imnodes.h"
 
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <variant>
 
 namespace ne {
@@ -20,13 +22,45 @@ namespace ne {
 
 	using ObjectRef = std::variant<std::reference_wrapper<VkAttachmentDescription>, std::reference_wrapper<YourStruct>, std::reference_wrapper<int>, std::reference_wrapper<float>>;
 
+	// Set of object types, one bit per ObjectRef alternative
+	using ObjectTypeMask = uint32_t;
+	static_assert(std::variant_size_v<ObjectRef> <= 32);
+	constexpr ObjectTypeMask allObjectTypes{ (1ull << std::variant_size_v<ObjectRef>) - 1 };
+
+	template <typename TObject, size_t ix = 0>
+	constexpr ObjectTypeMask ObjectTypeBit() {
+		static_assert(ix < std::variant_size_v<ObjectRef>, "not an ObjectRef type");
+		if constexpr (std::is_same_v<std::variant_alternative_t<ix, ObjectRef>, std::reference_wrapper<TObject>>)
+			return 1u << ix;
+		else
+			return ObjectTypeBit<TObject, ix + 1>();
+	}
+
+	// Closed set of attribute classes. Lets the graph tell attributes apart without RTTI.
+	enum class AttributeKind : uint8_t {
+		Value,
+		ObjectInput,
+		ObjectOutput,
+		Count,
+	};
+
+	// Whether a link can start at an attribute of row kind and end at an attribute of column kind
+	constexpr bool attributeKindsLinkable[][static_cast<size_t>(AttributeKind::Count)] = {
+		/* Value        */ { false, false, false },
+		/* ObjectInput  */ { false, false, false },
+		/* ObjectOutput */ { false, true, false },
+	};
+
 	class AttributeBase {
 	public:
 		// Members required by ImNode
 		int id{ -1 };
 		std::string name;
+		const AttributeKind kind;
+		// Node that owns the attribute, set when the node is added to a graph
+		int nodeId{ -1 };
 
-		AttributeBase(std::string name) : name{ name } {}
+		AttributeBase(std::string name, AttributeKind kind) : name{ name }, kind{ kind } {}
 
 		// Logic to draw Attribute UI in a Node body
 		virtual bool Draw() const = 0;
@@ -37,7 +71,7 @@ namespace ne {
 		ValueRef value;
 
 		ValueAttribute(std::string title, ValueRef value)
-			: AttributeBase{ title }, value{ value } {}
+			: AttributeBase{ title, AttributeKind::Value }, value{ value } {}
 
 		template <typename TVkEnum>
 		static bool DrawVkEnum(TVkEnum& val) {
@@ -62,7 +96,7 @@ namespace ne {
 		template <typename TVkFlags>
 		static bool DrawVkFlags(TVkFlags& val) {
 			bool wasUsed = false;
-			if (ImGui::BeginCombo("##hidelabel", enums::GetFlagLabel(val).c_str())) {
+			if (ImGui::BeginCombo("##hidelabel", enums::GetFlagLabel(val))) {
 				TVkFlags newVal = static_cast<TVkFlags>(0);
 				for (auto& [opVal, opLabel] : enums::GetDict<TVkFlags>()) {
 					bool isSelected = (opVal & val) == opVal;
@@ -117,7 +151,11 @@ namespace ne {
 		ObjectRef object;
 
 		ObjectOutputAttribute(ObjectRef obj)
-			: AttributeBase{ "out" }, object{ obj } {}
+			: AttributeBase{ "out", AttributeKind::ObjectOutput }, object{ obj } {}
+
+		ObjectTypeMask GetObjectType() const {
+			return 1u << object.index();
+		}
 
 		bool Draw() const {
 			return false;
@@ -127,9 +165,14 @@ namespace ne {
 	class ObjectInputAttribute : public AttributeBase {
 	public:
 		std::optional<ObjectRef> optObject;
-
-		ObjectInputAttribute() : AttributeBase{ "input" }, optObject{} {}
-		ObjectInputAttribute(ObjectRef object) : AttributeBase{ "input" }, optObject{ object } {}
+		// Types of objects that can be linked to this input
+		ObjectTypeMask acceptedTypes{ allObjectTypes };
+
+		ObjectInputAttribute(ObjectTypeMask acceptedTypes = allObjectTypes)
+			: ObjectInputAttribute{ "input", acceptedTypes } {}
+		ObjectInputAttribute(std::string name, ObjectTypeMask acceptedTypes)
+			: AttributeBase{ name, AttributeKind::ObjectInput }, optObject{}, acceptedTypes{ acceptedTypes } {}
+		ObjectInputAttribute(ObjectRef object) : AttributeBase{ "input", AttributeKind::ObjectInput }, optObject{ object } {}
 
 		bool Draw() const {
 			return false;
@@ -0,0 +1,115 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+FrameArena::FrameArena(size_t blockSize) : blockSize{ blockSize } {
+	blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+	Block& block = blocks.back();
+	const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+	const size_t alignedOffset = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+	if (alignedOffset + size <= block.size) {
+		offset = alignedOffset + size;
+		return block.data.get() + alignedOffset;
+	}
+
+	// Only happens in the first frames, or when a frame needs more than before. Merged by Reset.
+	const size_t newBlockSize = std::max(blockSize, size + alignment);
+	usedBytes += offset;
+	offset = 0;
+	blocks.push_back({ std::make_unique<std::byte[]>(newBlockSize), newBlockSize });
+	return Allocate(size, alignment);
+}
+
+const char* FrameArena::Format(const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+
+	// usually fits into the rest of current block, which is then formatted only once
+	Block& block = blocks.back();
+	char* dst = reinterpret_cast<char*>(block.data.get() + offset);
+	const size_t available = block.size - offset;
+	const int len = std::vsnprintf(dst, available, fmt, args);
+	va_end(args);
+	if (len < 0) {
+		va_end(argsCopy);
+		return "";
+	}
+	if (static_cast<size_t>(len) < available) {
+		offset += len + 1;
+		va_end(argsCopy);
+		return dst;
+	}
+
+	dst = static_cast<char*>(Allocate(len + 1, 1));
+	std::vsnprintf(dst, len + 1, fmt, argsCopy);
+	va_end(argsCopy);
+	return dst;
+}
+
+void FrameArena::Reset() {
+	if (blocks.size() > 1) {
+		const size_t capacity = GetCapacity();
+		blocks.clear();
+		blocks.push_back({ std::make_unique<std::byte[]>(capacity), capacity });
+	}
+	usedBytes = 0;
+	offset = 0;
+}
+
+size_t FrameArena::GetCapacity() const {
+	size_t capacity = 0;
+	for (const Block& block : blocks)
+		capacity += block.size;
+	return capacity;
+}
+
+FrameArena& FrameArena::Get() {
+	static FrameArena arena;
+	return arena;
+}
+
+// ----------------
+
+namespace {
+	// operator new can be called from any thread
+	std::atomic<uint64_t> numHeapAllocations{ 0 };
+}
+
+uint64_t GetNumHeapAllocations() {
+	return numHeapAllocations.load(std::memory_order_relaxed);
+}
+
+void* CountingMalloc(size_t size, void*) {
+	numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size);
+}
+
+void CountingFree(void* ptr, void*) {
+	std::free(ptr);
+}
+
+// Replacing these is enough to count all allocations of new expressions and standard containers,
+// since other forms of operator new, except the aligned ones, call them.
+void* operator new(size_t size) {
+	numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for memory that is only needed during a frame, e.g. labels of widgets.
+// Reset at the beginning of every frame. Blocks are kept across frames, hence there are no heap allocations in steady state.
+class FrameArena {
+public:
+	FrameArena(size_t blockSize = 64 * 1024);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Memory of count default constructed objects. Their destructors are never called.
+	template <typename T>
+	T* AllocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>);
+		T* ptr = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		for (size_t i = 0; i < count; ++i)
+			new (ptr + i) T{};
+		return ptr;
+	}
+	// printf-style formatting into the arena. Returned string is valid until next Reset.
+	const char* Format(const char* fmt, ...);
+	// Makes all memory of the frame available again. If the frame needed more than one block, they are merged into one.
+	void Reset();
+
+	size_t GetUsedBytes() const { return usedBytes + offset; }
+	size_t GetCapacity() const;
+
+	// Arena of the frame being built
+	static FrameArena& Get();
+private:
+	struct Block {
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	// bytes used in blocks before the current one
+	size_t usedBytes{ 0 };
+	size_t offset{ 0 };
+	size_t blockSize;
+};
+
+// Heap allocations of the program so far. Counts operator new, and ImGui's allocations after
+// ImGui::SetAllocatorFunctions(CountingMalloc, CountingFree)
+uint64_t GetNumHeapAllocations();
+void* CountingMalloc(size_t size, void* userData);
+void CountingFree(void* ptr, void* userData);
@@ -0,0 +1,166 @@
+#include "GraphCompiler.h"
+#include "Hash.h"
+
+#include <array>
+#include <cstring>
+
+GraphCompiler::GraphCompiler(const VulkanContext& vc, VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout)
+	: vc{ vc }, vert{ vert }, frag{ frag }, layout{ layout } {}
+
+GraphCompiler::~GraphCompiler() {
+	for (auto& [config, compiled] : cache) {
+		vkDestroyPipeline(vc.device, compiled.pipeline, nullptr);
+		vkDestroyRenderPass(vc.device, compiled.renderPass, nullptr);
+	}
+}
+
+size_t GraphCompiler::ConfigHash::operator()(const RenderPassConfig& config) const {
+	return static_cast<size_t>(HashBytes(&config, sizeof(config)));
+}
+
+bool GraphCompiler::ConfigEqual::operator()(const RenderPassConfig& a, const RenderPassConfig& b) const {
+	return std::memcmp(&a, &b, sizeof(RenderPassConfig)) == 0;
+}
+
+void GraphCompiler::Compile(ne::RenderPassNode& nd) {
+	// inputs only accept attachment descriptions
+	const auto getAttachment = [](const ne::ObjectInputAttribute& input) -> const VkAttachmentDescription* {
+		if (!input.optObject.has_value())
+			return nullptr;
+		const auto* ref = std::get_if<std::reference_wrapper<VkAttachmentDescription>>(&input.optObject.value());
+		return ref != nullptr ? &ref->get() : nullptr;
+	};
+	const VkAttachmentDescription* color = getAttachment(nd.colorInput);
+	const VkAttachmentDescription* depth = getAttachment(nd.depthInput);
+	if (color == nullptr) {
+		nd.renderPass = VK_NULL_HANDLE;
+		nd.pipeline = VK_NULL_HANDLE;
+		nd.status = "color input is not connected";
+		return;
+	}
+
+	RenderPassConfig config;
+	std::memset(&config, 0, sizeof(config));
+	config.color = *color;
+	if (depth != nullptr) {
+		config.depth = *depth;
+		config.hasDepth = 1;
+	}
+
+	// A tweak that goes back to a previous configuration, or another node with the same inputs, is a cache hit
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto it = cache.find(config);
+		if (it != cache.end()) {
+			++stats.numReused;
+			SetCompiled(nd, it->second, "reused from cache");
+			return;
+		}
+	}
+
+	CompiledRenderPass compiled{ Create(config) };
+	std::lock_guard<std::mutex> lock{ mutex };
+	const auto [it, inserted] = cache.emplace(config, compiled);
+	// another thread created the same configuration meanwhile
+	if (!inserted) {
+		vkDestroyPipeline(vc.device, compiled.pipeline, nullptr);
+		vkDestroyRenderPass(vc.device, compiled.renderPass, nullptr);
+		++stats.numReused;
+		SetCompiled(nd, it->second, "reused from cache");
+		return;
+	}
+	++stats.numCreated;
+	stats.numCached = cache.size();
+	SetCompiled(nd, it->second, "created");
+}
+
+void GraphCompiler::SetCompiled(ne::RenderPassNode& nd, const CompiledRenderPass& compiled, const char* status) {
+	nd.renderPass = compiled.renderPass;
+	nd.pipeline = compiled.pipeline;
+	nd.status = compiled.error != nullptr ? compiled.error : status;
+}
+
+GraphCompiler::Stats GraphCompiler::GetStats() const {
+	std::lock_guard<std::mutex> lock{ mutex };
+	return stats;
+}
+
+const char* GraphCompiler::Validate(const RenderPassConfig& config) const {
+	const auto supports = [this](VkFormat format, VkFormatFeatureFlags feature) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(vc.device.physical_device, format, &properties);
+		return (properties.optimalTilingFeatures & feature) == feature;
+	};
+	const auto isSingleSampleCount = [](VkSampleCountFlagBits samples) {
+		return samples != 0 && samples <= VK_SAMPLE_COUNT_64_BIT && (samples & (samples - 1)) == 0;
+	};
+	const auto isDepthLayout = [](VkImageLayout layout) {
+		return layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL || layout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+			|| layout == VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL;
+	};
+
+	std::array<const VkAttachmentDescription*, 2> attachments{ &config.color, config.hasDepth ? &config.depth : nullptr };
+	for (const VkAttachmentDescription* attachment : attachments) {
+		if (attachment == nullptr)
+			continue;
+		if (attachment->finalLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			return "final layout cannot be undefined";
+		if (!isSingleSampleCount(attachment->samples))
+			return "samples should be a single count";
+		// VK_EXT_load_store_op_none is not enabled
+		if (attachment->loadOp == VK_ATTACHMENT_LOAD_OP_NONE_EXT || attachment->stencilLoadOp == VK_ATTACHMENT_LOAD_OP_NONE_EXT
+			|| attachment->storeOp == VK_ATTACHMENT_STORE_OP_NONE_EXT || attachment->stencilStoreOp == VK_ATTACHMENT_STORE_OP_NONE_EXT)
+			return "None ops are not supported";
+	}
+
+	if (config.color.format == VK_FORMAT_UNDEFINED || !supports(config.color.format, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT))
+		return "color format cannot be rendered to";
+	if (isDepthLayout(config.color.initialLayout) || isDepthLayout(config.color.finalLayout))
+		return "color attachment cannot have a depth layout";
+	if (config.hasDepth) {
+		if (config.depth.format == VK_FORMAT_UNDEFINED || !supports(config.depth.format, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT))
+			return "depth format cannot be a depth attachment";
+		if (config.depth.initialLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL || config.depth.finalLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+			return "depth attachment cannot have a color layout";
+		if (config.depth.samples != config.color.samples)
+			return "attachments should have the same samples";
+	}
+	return nullptr;
+}
+
+GraphCompiler::CompiledRenderPass GraphCompiler::Create(const RenderPassConfig& config) const {
+	CompiledRenderPass compiled;
+	compiled.error = Validate(config);
+	if (compiled.error != nullptr)
+		return compiled;
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = config.hasDepth ? &depthAttachmentRef : nullptr;
+
+	const std::array<VkAttachmentDescription, 2> attachments{ config.color, config.depth };
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = config.hasDepth ? 2 : 1;
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+
+	if (vkCreateRenderPass(vc.device, &renderPassInfo, nullptr, &compiled.renderPass) != VK_SUCCESS) {
+		compiled.renderPass = VK_NULL_HANDLE;
+		compiled.error = "driver cannot create the render pass";
+		return compiled;
+	}
+	compiled.pipeline = vc.CreatePipeline(vert, frag, layout, compiled.renderPass, config.color.samples);
+	return compiled;
+}
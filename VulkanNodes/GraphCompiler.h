@@ -0,0 +1,66 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "NodeEditor.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// Turns RenderPass nodes of a graph into Vulkan objects. Objects are cached by the configuration they are made of,
+// so that going back to a previous configuration, or another node with the same inputs, reuses them instead of creating new ones.
+class GraphCompiler {
+public:
+	// Pipelines are made of given shaders and layout, which have to be alive as long as the compiler
+	GraphCompiler(const VulkanContext& vc, VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout);
+	GraphCompiler(const GraphCompiler&) = delete;
+	GraphCompiler& operator=(const GraphCompiler&) = delete;
+	~GraphCompiler();
+
+	// Sets objects of node made of its current inputs. Called when the node is evaluated, i.e. when its inputs changed.
+	// Thread-safe, objects of different configurations are created concurrently.
+	void Compile(ne::RenderPassNode& nd);
+
+	struct Stats {
+		// configurations compiled, i.e. cache misses
+		uint32_t numCreated{ 0 };
+		// compilations served from the cache
+		uint32_t numReused{ 0 };
+		size_t numCached{ 0 };
+	};
+	Stats GetStats() const;
+private:
+	// Everything the objects are made of. Zero initialized before filling, so that bytes can be hashed and compared.
+	struct RenderPassConfig {
+		VkAttachmentDescription color;
+		VkAttachmentDescription depth;
+		uint32_t hasDepth;
+	};
+	struct ConfigHash {
+		size_t operator()(const RenderPassConfig& config) const;
+	};
+	struct ConfigEqual {
+		bool operator()(const RenderPassConfig& a, const RenderPassConfig& b) const;
+	};
+	// Invalid configurations are cached too, so that they are not validated again every frame
+	struct CompiledRenderPass {
+		VkRenderPass renderPass{ VK_NULL_HANDLE };
+		VkPipeline pipeline{ VK_NULL_HANDLE };
+		// nullptr if objects were created
+		const char* error{ nullptr };
+	};
+
+	const VulkanContext& vc;
+	VkShaderModule vert;
+	VkShaderModule frag;
+	VkPipelineLayout layout;
+	// guards cache and stats, not held while objects are created
+	mutable std::mutex mutex;
+	std::unordered_map<RenderPassConfig, CompiledRenderPass, ConfigHash, ConfigEqual> cache;
+	Stats stats;
+
+	// nullptr if objects can be made of config, reason otherwise
+	const char* Validate(const RenderPassConfig& config) const;
+	CompiledRenderPass Create(const RenderPassConfig& config) const;
+	static void SetCompiled(ne::RenderPassNode& nd, const CompiledRenderPass& compiled, const char* status);
+};
@@ -0,0 +1,101 @@
+#include "Headless.h"
+#include "NodeEditor.h"
+#include "Serialization.h"
+#include "FrameArena.h"
+
+#include <imgui.h>
+#include "dependencies/imnodes.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+	bool IsJsonPath(const std::string& path) {
+		const std::string ext{ ".json" };
+		return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int RunHeadless(const HeadlessOptions& options) {
+	// ImNodes context is needed by NodeEditor even when no frames are built
+	ImGui::SetAllocatorFunctions(CountingMalloc, CountingFree);
+	ImGui::CreateContext();
+	ImNodes::CreateContext();
+	ImGuiIO& io{ ImGui::GetIO() };
+	io.IniFilename = nullptr;
+	io.DisplaySize = ImVec2{ 1920.0f, 1080.0f };
+	io.DeltaTime = 1.0f / 60.0f;
+	// Font atlas has to be built before a frame. Its pixels are never uploaded.
+	unsigned char* fontPixels;
+	int fontWidth, fontHeight;
+	io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+
+	int exitCode{ EXIT_SUCCESS };
+	{
+		ne::NodeEditor nodeEditor{};
+		// Positions of loaded nodes, so that they are exported even if nodes were never drawn
+		std::unordered_map<int, ImVec2> nodePositions;
+
+		auto start = std::chrono::steady_clock::now();
+		if (options.loadPath.empty())
+			nodeEditor.graph = ne::NodeEditor::MakeTestGraph();
+		else {
+			const auto setNodePos = [&](int nodeId, ImVec2 pos) {
+				nodePositions[nodeId] = pos;
+				ImNodes::SetNodeGridSpacePos(nodeId, pos);
+			};
+			const bool loaded = IsJsonPath(options.loadPath) ? ne::LoadGraphJson(options.loadPath, nodeEditor.graph, setNodePos)
+				: ne::LoadGraph(options.loadPath, nodeEditor.graph, setNodePos);
+			if (!loaded)
+				exitCode = EXIT_FAILURE;
+		}
+		const ne::Graph& graph{ nodeEditor.graph };
+		std::cout << "graph: " << graph.nodes.size() << " nodes, " << graph.links.size() << " links, "
+			<< graph.attributes.size() << " attributes, loaded in " << MillisecondsSince(start) << " ms\n";
+
+		if (exitCode == EXIT_SUCCESS && options.numFrames > 0) {
+			start = std::chrono::steady_clock::now();
+			int numVertices{};
+			uint64_t lastFrameHeapAllocations{};
+			for (int i = 0; i < options.numFrames; ++i) {
+				const uint64_t frameStartHeapAllocations{ GetNumHeapAllocations() };
+				FrameArena::Get().Reset();
+				ImGui::NewFrame();
+				nodeEditor.Draw();
+				ImGui::Render();
+				numVertices += ImGui::GetDrawData()->TotalVtxCount;
+				lastFrameHeapAllocations = GetNumHeapAllocations() - frameStartHeapAllocations;
+			}
+			const double duration = MillisecondsSince(start);
+			std::cout << "frames: " << options.numFrames << " in " << duration << " ms, " << duration / options.numFrames
+				<< " ms per frame, " << numVertices / options.numFrames << " vertices per frame, "
+				<< lastFrameHeapAllocations << " heap allocations in last frame\n";
+		}
+
+		if (exitCode == EXIT_SUCCESS && !options.exportPath.empty()) {
+			const auto getNodePos = [&](int nodeId) {
+				auto it = nodePositions.find(nodeId);
+				return it != nodePositions.end() ? it->second : ImVec2{};
+			};
+			start = std::chrono::steady_clock::now();
+			const bool saved = IsJsonPath(options.exportPath) ? ne::SaveGraphJson(options.exportPath, graph, getNodePos)
+				: ne::SaveGraph(options.exportPath, graph, getNodePos);
+			if (saved)
+				std::cout << "exported to " << options.exportPath << " in " << MillisecondsSince(start) << " ms\n";
+			else {
+				std::cerr << "Cannot save graph to " << options.exportPath << std::endl;
+				exitCode = EXIT_FAILURE;
+			}
+		}
+	}
+
+	ImNodes::DestroyContext();
+	ImGui::DestroyContext();
+	return exitCode;
+}
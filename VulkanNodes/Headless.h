@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+// Runs graph operations without a window or a GPU, e.g. on build servers
+struct HeadlessOptions {
+	// graph file to load, the test graph if empty. ".json" files are read as JSON, others as binary.
+	std::string loadPath;
+	// graph file to write after processing, nothing is written if empty
+	std::string exportPath;
+	// number of ImGui frames to build into CPU-side draw lists. No frames are built if 0.
+	int numFrames{ 0 };
+};
+
+// Returns process exit code
+int RunHeadless(const HeadlessOptions& options);
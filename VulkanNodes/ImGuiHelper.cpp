@@ -1,9 +1,11 @@
 #include "ImGuiHelper.h"
+#include "FrameArena.h"
 
 #include <imgui_impl_vulkan.h>
 #include <imgui_impl_glfw.h>
 #include "dependencies/imnodes.h"
 
+#include <algorithm>
 #include <cassert>
 
 ImGuiHelper::ImGuiHelper(const VulkanContext& vc)
@@ -36,9 +38,19 @@ ImGuiHelper::ImGuiHelper(const VulkanContext& vc)
 
 
 	IMGUI_CHECKVERSION();
+	// so that allocations of ImGui show up in per frame allocation counts
+	ImGui::SetAllocatorFunctions(CountingMalloc, CountingFree);
 	ImGui::CreateContext();
 	ImNodes::CreateContext();
-	ImGui_ImplGlfw_InitForVulkan(vc.win.GetGLFWWindow(), true);
+	// Offscreen there are no window and no input. Display size and time step are fixed, so that frames are reproducible.
+	if (vc.IsOffscreen()) {
+		ImGuiIO& io = ImGui::GetIO();
+		io.IniFilename = nullptr;
+		io.DisplaySize = ImVec2{ static_cast<float>(vc.GetExtent().width), static_cast<float>(vc.GetExtent().height) };
+		io.DeltaTime = 1.0f / 60.0f;
+	}
+	else
+		ImGui_ImplGlfw_InitForVulkan(vc.win->GetGLFWWindow(), true);
 
 	ImGui_ImplVulkan_InitInfo init_info = {};
 	init_info.Instance = vc.instance;
@@ -46,10 +58,12 @@ ImGuiHelper::ImGuiHelper(const VulkanContext& vc)
 	init_info.Device = vc.device;
 	//init_info.QueueFamily = device.get_queue_index(vkb::QueueType::graphics).value();
 	init_info.Queue = vc.graphics_queue;
-	//init_info.PipelineCache = g_PipelineCache;
+	init_info.PipelineCache = vc.pipelineCache;
 	init_info.DescriptorPool = imguiPool;
-	init_info.MinImageCount = static_cast<uint32_t>(vc.surfaceFramebuffers.size());
-	init_info.ImageCount = static_cast<uint32_t>(vc.surfaceFramebuffers.size());
+	// ImGui requires at least 2, offscreen has a single framebuffer.
+	// ImGui cycles its vertex buffers by ImageCount, which should cover frames in flight so that a buffer in use by GPU is not overwritten.
+	init_info.MinImageCount = std::max({ static_cast<uint32_t>(vc.surfaceFramebuffers.size()), 2u, static_cast<uint32_t>(VulkanContext::MAX_FRAMES_IN_FLIGHT) });
+	init_info.ImageCount = init_info.MinImageCount;
 	init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 	//init_info.CheckVkResultFn = check_vk_result;
 	ImGui_ImplVulkan_Init(&init_info, vc.surfaceRenderPass);
@@ -57,7 +71,7 @@ ImGuiHelper::ImGuiHelper(const VulkanContext& vc)
 	// Upload fonts
 	{
 		VkCommandPool command_pool = vc.commandPool;
-		VkCommandBuffer command_buffer = vc.commandBuffer;
+		VkCommandBuffer command_buffer = vc.commandBuffers[0];
 
 		vkResetCommandPool(vc.device, command_pool, 0);
 		VkCommandBufferBeginInfo begin_info = {};
@@ -82,14 +96,16 @@ ImGuiHelper::ImGuiHelper(const VulkanContext& vc)
 ImGuiHelper::~ImGuiHelper() {
 	vkDestroyDescriptorPool(vc.device, imguiPool, nullptr);
 	ImGui_ImplVulkan_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
+	if (!vc.IsOffscreen())
+		ImGui_ImplGlfw_Shutdown();
 	ImNodes::DestroyContext();
 	ImGui::DestroyContext();
 }
 
 void ImGuiHelper::Begin() const {
 	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
+	if (!vc.IsOffscreen())
+		ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 }
 
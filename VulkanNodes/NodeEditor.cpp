@@ -1,6 +1,9 @@
 #include "NodeEditor.h"
+#include "Serialization.h"
 
+#include <iostream>
 #include <string>
+#include <vector>
 
 namespace ne {
 	NodeEditor::NodeEditor(const Graph& graph) : graph{ graph } {
@@ -14,19 +17,21 @@ namespace ne {
 
 	void NodeEditor::Draw() {
 		ImGui::Begin("Node Editor");
-		ImGui::TextUnformatted("A: add node. CTRL+s: save node pos. CTRL+l: load node pos.");
+		ImGui::TextUnformatted("A: add node. Delete: remove selected nodes. CTRL+s: save graph. CTRL+l: load graph. Add SHIFT for JSON. Mouse wheel: zoom.");
 		// Hack for learning key codes
 		//for (int key = 0; key < 200; key++) { if (ImGui::IsKeyDown(key)) ImGui::Text("key: %d", key); }
 		ImNodes::BeginNodeEditor();
 
 		DrawPopupMenu();
 		DrawNodesAndLinks();
-		SaveLoadGraph();
 		ImNodes::MiniMap(0.2f, ImNodesMiniMapLocation_BottomRight);
 
 		ImNodes::EndNodeEditor();
 
 		CreateDeleteLinks();
+		DeleteSelectedNodes();
+		// after links and nodes of this frame are handled, since loading replaces all of them
+		SaveLoadGraph();
 
 		ImGui::End();
 	}
@@ -56,6 +61,10 @@ namespace ne {
 				auto node = graph.AddNode<ObjectViewerNode>();
 				ImNodes::SetNodeScreenSpacePos(node->id, clickPos);
 			}
+			if (ImGui::MenuItem("RenderPass")) {
+				auto node = graph.AddNode<RenderPassNode>();
+				ImNodes::SetNodeScreenSpacePos(node->id, clickPos);
+			}
 
 			ImGui::EndPopup();
 		}
@@ -64,26 +73,45 @@ namespace ne {
 	}
 
 	void NodeEditor::DrawNodesAndLinks() {
-		for (const auto& pair : graph.nodes) {
-			NodeBase& nd = *pair.second;
-			nd.Draw();
+		// Nodes outside of the canvas don't submit their widgets, only keep their imnodes state alive
+		for (const std::shared_ptr<NodeBase>& ndPtr : graph.nodes) {
+			NodeBase& nd = *ndPtr;
+			// an edited value makes the node and the nodes downstream of it dirty
+			if (ImNodes::IsNodeOnCanvas(nd.id)) {
+				if (nd.Draw(detailThresholds))
+					graph.MarkDirty(nd.id);
+			}
+			else
+				ImNodes::NodePlaceholder(nd.id);
 		}
-		//for (const auto& [id, link] : graph.links) {
-		for (const auto& pair : graph.links) {
-			const Link& lnk = pair.second;
+		// Submitting a link is only a lookup. Links outside of the canvas are not drawn by imnodes.
+		for (const Link& lnk : graph.links) {
 			ImNodes::Link(lnk.id, lnk.startAttrId, lnk.endAttrId);
 		}
 	}
 
 	void NodeEditor::SaveLoadGraph() {
-		// TODO: fix save/load. It is just saving positions of a fixed graph
-		const char* editorStateSaveFile{ "editor_state.ini" };
+		// Graph file has nodes, links and node positions. Editor state has panning.
+		// Binary file is quick to load, JSON file is for version control.
 		ImGuiIO& io{ ImGui::GetIO() };
+		const bool asJson{ io.KeyShift };
+		const char* graphSaveFile{ asJson ? "graph.json" : "graph.vng" };
+		const char* editorStateSaveFile{ "editor_state.ini" };
 		if (io.KeyCtrl && ImGui::IsKeyPressed(83, false)) {
+			const bool saved = asJson ? SaveGraphJson(graphSaveFile, graph, ImNodes::GetNodeGridSpacePos)
+				: SaveGraph(graphSaveFile, graph, ImNodes::GetNodeGridSpacePos);
+			if (!saved)
+				std::cerr << "Cannot save graph to " << graphSaveFile << std::endl;
 			ImNodes::SaveCurrentEditorStateToIniFile(editorStateSaveFile);
 		}
 		else if (io.KeyCtrl && ImGui::IsKeyPressed(76, false)) {
-			ImNodes::LoadCurrentEditorStateFromIniFile(editorStateSaveFile);
+			const bool loaded = asJson ? LoadGraphJson(graphSaveFile, graph, ImNodes::SetNodeGridSpacePos)
+				: LoadGraph(graphSaveFile, graph, ImNodes::SetNodeGridSpacePos);
+			if (loaded) {
+				ImNodes::ClearNodeSelection();
+				ImNodes::ClearLinkSelection();
+				ImNodes::LoadCurrentEditorStateFromIniFile(editorStateSaveFile);
+			}
 		}
 	}
 
@@ -97,6 +125,23 @@ namespace ne {
 			graph.RemoveLink(linkId);
 	}
 
+	void NodeEditor::DeleteSelectedNodes() {
+		// 261 is Delete key. Don't steal it from a text field of a node.
+		const bool shouldDelete = ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows) &&
+			!ImGui::GetIO().WantTextInput &&
+			ImGui::IsKeyPressed(261, false);
+		const int numSelected = ImNodes::NumSelectedNodes();
+		if (!shouldDelete || numSelected == 0)
+			return;
+
+		std::vector<int> selectedIds(numSelected);
+		ImNodes::GetSelectedNodes(selectedIds.data());
+		graph.RemoveNodes(selectedIds.data(), selectedIds.size());
+		// imnodes keeps selection across frames, which would refer to removed nodes and links
+		ImNodes::ClearNodeSelection();
+		ImNodes::ClearLinkSelection();
+	}
+
 	Graph NodeEditor::MakeTestGraph() {
 		Graph graph{};
 		auto nd1 = graph.AddNode<ObjectEditorNode<VkAttachmentDescription>>("VkAttachmentDescription1", static_cast<VkAttachmentDescriptionFlags>(0), VK_FORMAT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT);
@@ -2,14 +2,18 @@
 
 #include "Attributes.h"
 #include "Nodes.h"
+#include "SlotMap.h"
+#include "Hash.h"
+#include "TaskScheduler.h"
 
 #include "dependencies/imnodes.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace ne {
 	struct Link {
@@ -18,72 +22,109 @@ namespace ne {
 		int endAttrId;
 	};
 
+	// Links attached to an attribute
+	struct AttributeLinks {
+		// an input attribute has at most one link, -1 if not connected
+		int incoming{ -1 };
+		std::vector<int> outgoing;
+	};
+
 	class Graph {
 	public:
-		// Graph owns nodes and links
-		std::unordered_map<int, std::shared_ptr<NodeBase>> nodes;
-		std::unordered_map<int, Link> links;
+		// Graph owns nodes and links. Ids of nodes, links and attributes are handed out by their SlotMaps.
+		SlotMap<std::shared_ptr<NodeBase>> nodes;
+		SlotMap<Link> links;
 		// Since attributes are owned by nodes, graph only have references to them
-		std::unordered_map<int, std::reference_wrapper<AttributeBase>> attributes;
-		int counter{};
+		SlotMap<std::reference_wrapper<AttributeBase>> attributes;
 
+		// Add a node whose id and attribute ids were handed out before, i.e. by a previously saved graph
 		void AddNode(std::shared_ptr<NodeBase> nd) {
 			assert(nd->id != -1); // node should be given an id
 			for (auto attrRef : nd->GetAllAttributes()) {
 				assert(attrRef.get().id != -1);  // all attributes of a node should be given an id
-				attributes.insert(std::make_pair(attrRef.get().id, attrRef));
+				attrRef.get().nodeId = nd->id;
+				attributes.insert_at(attrRef.get().id, attrRef);
 			}
-			nodes[nd->id] = nd;				
+			nodes.insert_at(nd->id, nd);
+			MarkDirty(nd->id);
 		}
 
 		template<IsNode TNode, typename... Args>
 		std::shared_ptr<TNode> AddNode(Args... args) {
 			std::shared_ptr<TNode> nd = std::make_shared<TNode>(args...);
-			nd->id = counter++;
-			nodes[nd->id] = nd;
+			nd->id = nodes.insert(nd);
 
 			for (auto attrRef : nd->GetAllAttributes()) {
-				attrRef.get().id = counter++;
-				attributes.insert(std::make_pair(attrRef.get().id, attrRef));
+				attrRef.get().id = attributes.insert(attrRef);
+				attrRef.get().nodeId = nd->id;
 			}
+			MarkDirty(nd->id);
 			return nd;
 		}
 
-		// TODO: RemoveNode()
+		void RemoveNode(int id) {
+			RemoveNodes(&id, 1);
+		}
+
+		// Removes nodes together with their attributes and the links attached to them.
+		// Inputs that were fed by a removed node lose their view reference.
+		void RemoveNodes(const int* ids, size_t count) {
+			for (size_t i = 0; i < count; ++i) {
+				assert(nodes.contains(ids[i])); // node to be removed should exist
+				NodeBase& nd = *nodes.at(ids[i]);
+
+				for (auto attrRef : nd.GetAllAttributes()) {
+					const int attrId = attrRef.get().id;
+					// links between two removed nodes are removed when the first one is visited
+					AttributeLinks& attrLinks = LinksOf(attrId);
+					if (attrLinks.incoming != -1)
+						RemoveLink(attrLinks.incoming);
+					while (!attrLinks.outgoing.empty())
+						RemoveLink(attrLinks.outgoing.back());
+					attributes.erase(attrId);
+				}
+				// attributes are owned by the node, hence remove their references first
+				nodes.erase(ids[i]);
+			}
+		}
 
-		Link& AddLink(int startAttrId, int endAttrId) {
+		// Returns id of the new link, -1 if attributes cannot be linked
+		int AddLink(int startAttrId, int endAttrId) {
 			assert(attributes.contains(startAttrId));
 			assert(attributes.contains(endAttrId));
 
 			return AddLink(attributes.at(startAttrId), attributes.at(endAttrId));
 		}
 
-		Link& AddLink(AttributeBase& attr1, AttributeBase& attr2) {
-			AttributeBase* pBase1 = &attr1;
-			AttributeBase* pBase2 = &attr2;
-			if (ObjectInputAttribute* attrIn = dynamic_cast<ObjectInputAttribute*>(pBase2)) {
-				if (ObjectOutputAttribute* attrOut = dynamic_cast<ObjectOutputAttribute*>(pBase1)) {
-
-					// does input attr already has connection?
-					std::vector<int> linksToDelete;
-					for (const auto& [linkId, link] : links) {
-						// if yes, mark input's link for deletion, and reset view reference
-						if (link.endAttrId == attrIn->id) {
-							linksToDelete.push_back(linkId);
-							attrIn->optObject.reset();
-						}
-					}
-					for (int linkId : linksToDelete)
-						links.erase(linkId);
-					// new view reference
-					attrIn->optObject = attrOut->object;
-
-					const int id = ++counter;
-					links[id] = { id, attr1.id, attr2.id };
-					return links[id];
-				}
-			}
+		static bool CanLink(const AttributeBase& attr1, const AttributeBase& attr2) {
+			if (!attributeKindsLinkable[static_cast<size_t>(attr1.kind)][static_cast<size_t>(attr2.kind)])
+				return false;
+			// only output -> input is linkable, hence the kinds are known
+			const auto& attrOut = static_cast<const ObjectOutputAttribute&>(attr1);
+			const auto& attrIn = static_cast<const ObjectInputAttribute&>(attr2);
+			return (attrOut.GetObjectType() & attrIn.acceptedTypes) != 0;
+		}
+
+		int AddLink(AttributeBase& attr1, AttributeBase& attr2) {
 			// don't link in any other cases
+			if (!CanLink(attr1, attr2))
+				return -1;
+			auto& attrOut = static_cast<ObjectOutputAttribute&>(attr1);
+			auto& attrIn = static_cast<ObjectInputAttribute&>(attr2);
+
+			// does input attr already has connection? if yes, replace it
+			const int oldLinkId = GetIncomingLink(attrIn.id);
+			if (oldLinkId != -1)
+				RemoveLink(oldLinkId);
+			// new view reference
+			attrIn.optObject = attrOut.object;
+
+			const int id = links.insert({ -1, attr1.id, attr2.id });
+			links.at(id).id = id;
+			LinksOf(attr1.id).outgoing.push_back(id);
+			LinksOf(attr2.id).incoming = id;
+			MarkDirty(attrIn.nodeId);
+			return id;
 		}
 
 		void RemoveLink(int id) {
@@ -91,12 +132,254 @@ namespace ne {
 
 			const auto& link = links.at(id);
 			AttributeBase& in = attributes.at(link.endAttrId);
-			AttributeBase* pIn = &in;
-			ObjectInputAttribute* attrIn = dynamic_cast<ObjectInputAttribute*>(pIn);
-			if (attrIn)
-				attrIn->optObject.reset();
+			if (in.kind == AttributeKind::ObjectInput)
+				static_cast<ObjectInputAttribute&>(in).optObject.reset();
+			MarkDirty(in.nodeId);
+
+			LinksOf(link.endAttrId).incoming = -1;
+			// outputs rarely feed more than a few inputs, and order doesn't matter
+			std::vector<int>& outgoing = LinksOf(link.startAttrId).outgoing;
+			auto it = std::find(outgoing.begin(), outgoing.end(), id);
+			assert(it != outgoing.end());
+			*it = outgoing.back();
+			outgoing.pop_back();
+
 			links.erase(id);
 		}
+
+		// Link ending at given input attribute, -1 if it is not connected
+		int GetIncomingLink(int attrId) const {
+			const uint32_t slotIx = decltype(attributes)::IndexOf(attrId);
+			return slotIx < attributeLinks.size() ? attributeLinks[slotIx].incoming : -1;
+		}
+
+		// Links starting at given output attribute
+		const std::vector<int>& GetOutgoingLinks(int attrId) const {
+			static const std::vector<int> none;
+			const uint32_t slotIx = decltype(attributes)::IndexOf(attrId);
+			return slotIx < attributeLinks.size() ? attributeLinks[slotIx].outgoing : none;
+		}
+
+		// Node has to be evaluated again, e.g. a value of it was edited. Nodes downstream of it are evaluated too.
+		void MarkDirty(int nodeId) {
+			dirtyNodes.push_back(nodeId);
+		}
+		bool HasDirtyNodes() const { return !dirtyNodes.empty(); }
+
+		struct EvaluationStats {
+			// Evaluate calls that had dirty nodes, i.e. edits
+			uint32_t numEvaluations{ 0 };
+			size_t lastNumDirty{ 0 };
+			// Dirty nodes and nodes downstream of them are either evaluated, i.e. memo misses,
+			// or reused since their content hash didn't change, i.e. memo hits
+			size_t lastNumEvaluated{ 0 };
+			size_t lastNumReused{ 0 };
+			size_t totalNumEvaluated{ 0 };
+			size_t totalNumReused{ 0 };
+		};
+		EvaluationStats GetEvaluationStats() const { return evaluationStats; }
+
+		// Calls evaluateNode(NodeBase&) once for each dirty node and each node downstream of them, after the nodes that feed it.
+		// A node whose content hash is the same as at its last evaluation keeps its results and is not evaluated again,
+		// e.g. when an edit is undone, or when an input is relinked to an identical node. Then nodes downstream of it aren't either.
+		// Returns the number of evaluated nodes. Only checks a flag when nothing changed, hence can be called every frame.
+		// evaluateNode should not add or remove nodes and links. Nodes on a cycle are not evaluated.
+		template <typename TEvaluate>
+		size_t Evaluate(TEvaluate&& evaluateNode) {
+			if (dirtyNodes.empty())
+				return 0;
+			EvaluationPlan plan{ PlanEvaluation() };
+
+			// Kahn's algorithm
+			std::vector<size_t> ready;
+			for (size_t i = 0; i < plan.affected.size(); ++i)
+				if (plan.numInputs[i] == 0)
+					ready.push_back(i);
+			size_t numEvaluated = 0;
+			size_t numReused = 0;
+			while (!ready.empty()) {
+				const size_t i = ready.back();
+				ready.pop_back();
+				if (EvaluateIfChanged(*nodes.at(plan.affected[i]), evaluateNode))
+					++numEvaluated;
+				else
+					++numReused;
+				for (size_t j = plan.offsets[i]; j < plan.offsets[i + 1]; ++j)
+					if (--plan.numInputs[plan.successors[j]] == 0)
+						ready.push_back(plan.successors[j]);
+			}
+			RecordEvaluation(plan, numEvaluated, numReused);
+			return numEvaluated;
+		}
+
+		// Same as Evaluate, but nodes whose inputs are ready are evaluated concurrently on scheduler, and on the calling thread.
+		// evaluateNode is called from multiple threads, never for the same node, nor for a node and one feeding it at the same time.
+		template <typename TEvaluate>
+		size_t Evaluate(TaskScheduler& scheduler, TEvaluate&& evaluateNode) {
+			if (dirtyNodes.empty())
+				return 0;
+			EvaluationPlan plan{ PlanEvaluation() };
+			// not worth waking up workers
+			if (plan.affected.size() == 1) {
+				const size_t numEvaluated = EvaluateIfChanged(*nodes.at(plan.affected[0]), evaluateNode) ? 1 : 0;
+				RecordEvaluation(plan, numEvaluated, 1 - numEvaluated);
+				return numEvaluated;
+			}
+
+			// A node is submitted by the last node that feeds it, i.e. the one that brings its pending inputs to 0
+			struct Evaluation {
+				Graph& graph;
+				const EvaluationPlan& plan;
+				TEvaluate& evaluateNode;
+				TaskScheduler& scheduler;
+				TaskScheduler::TaskGroup group{};
+				std::vector<std::atomic<uint32_t>> numPendingInputs;
+				std::atomic<size_t> numEvaluated{ 0 };
+				std::atomic<size_t> numReused{ 0 };
+
+				void Run(size_t i) {
+					if (graph.EvaluateIfChanged(*graph.nodes.at(plan.affected[i]), evaluateNode))
+						numEvaluated.fetch_add(1, std::memory_order_relaxed);
+					else
+						numReused.fetch_add(1, std::memory_order_relaxed);
+					for (size_t j = plan.offsets[i]; j < plan.offsets[i + 1]; ++j) {
+						const size_t succIx = plan.successors[j];
+						if (numPendingInputs[succIx].fetch_sub(1, std::memory_order_acq_rel) == 1)
+							scheduler.Submit(group, [this, succIx]() { Run(succIx); });
+					}
+				}
+			};
+			Evaluation evaluation{ *this, plan, evaluateNode, scheduler, {}, std::vector<std::atomic<uint32_t>>(plan.affected.size()) };
+			for (size_t i = 0; i < plan.affected.size(); ++i)
+				evaluation.numPendingInputs[i].store(plan.numInputs[i], std::memory_order_relaxed);
+			for (size_t i = 0; i < plan.affected.size(); ++i)
+				if (plan.numInputs[i] == 0)
+					scheduler.Submit(evaluation.group, [&evaluation, i]() { evaluation.Run(i); });
+			scheduler.Wait(evaluation.group);
+
+			const size_t numEvaluated = evaluation.numEvaluated.load();
+			RecordEvaluation(plan, numEvaluated, evaluation.numReused.load());
+			return numEvaluated;
+		}
+
+		// Appends ids of nodes that have an input linked to an output of given node. A node is repeated per link.
+		void AppendSuccessors(int nodeId, std::vector<int>& successorIds) {
+			for (auto attrRef : nodes.at(nodeId)->GetAllAttributes()) {
+				const AttributeBase& attr = attrRef.get();
+				if (attr.kind != AttributeKind::ObjectOutput)
+					continue;
+				for (int linkId : GetOutgoingLinks(attr.id))
+					successorIds.push_back(attributes.at(links.at(linkId).endAttrId).get().nodeId);
+			}
+		}
+
+	private:
+		// Adjacency of attributes, indexed by the slot of the attribute id, so that it is found without hashing
+		std::vector<AttributeLinks> attributeLinks;
+		// Marked since last Evaluate, can have duplicates and removed nodes
+		std::vector<int> dirtyNodes;
+		EvaluationStats evaluationStats;
+
+		// Dirty nodes and nodes downstream of them, with links between them in CSR form
+		struct EvaluationPlan {
+			// ids of nodes, dirty ones first
+			std::vector<int> affected;
+			size_t numDirty{ 0 };
+			// successors of affected[i] are successors[offsets[i]..offsets[i + 1]), as indices into affected
+			std::vector<size_t> successors;
+			std::vector<size_t> offsets;
+			// links coming from affected nodes, by index into affected. Other nodes cannot feed an affected node.
+			std::vector<uint32_t> numInputs;
+		};
+
+		// Takes dirty nodes
+		EvaluationPlan PlanEvaluation() {
+			EvaluationPlan plan{};
+			// 1 + index in affected, by slot of node id. 0 if node is not affected.
+			std::vector<uint32_t> positions;
+			const auto positionOf = [&](int nodeId) -> uint32_t& {
+				const uint32_t slotIx = decltype(nodes)::IndexOf(nodeId);
+				if (slotIx >= positions.size())
+					positions.resize(slotIx + 1, 0);
+				return positions[slotIx];
+			};
+			const auto visit = [&](int nodeId) {
+				// nodes can be removed after they were marked
+				if (!nodes.contains(nodeId) || positionOf(nodeId) != 0)
+					return;
+				plan.affected.push_back(nodeId);
+				positionOf(nodeId) = static_cast<uint32_t>(plan.affected.size());
+			};
+			for (int nodeId : dirtyNodes)
+				visit(nodeId);
+			plan.numDirty = plan.affected.size();
+			dirtyNodes.clear();
+
+			// breadth first, affected grows while it is traversed
+			std::vector<int> successorIds;
+			plan.offsets.push_back(0);
+			for (size_t i = 0; i < plan.affected.size(); ++i) {
+				AppendSuccessors(plan.affected[i], successorIds);
+				for (size_t j = plan.offsets[i]; j < successorIds.size(); ++j)
+					visit(successorIds[j]);
+				plan.offsets.push_back(successorIds.size());
+			}
+
+			plan.successors.reserve(successorIds.size());
+			plan.numInputs.resize(plan.affected.size(), 0);
+			for (int nodeId : successorIds) {
+				const size_t succIx = positionOf(nodeId) - 1;
+				plan.successors.push_back(succIx);
+				++plan.numInputs[succIx];
+			}
+			return plan;
+		}
+
+		// Hash of what evaluating a node depends on: its kind, its values, and the content hashes of the nodes linked to its inputs.
+		// Nodes with equal content hashes evaluate to equal results. Never 0. Upstream nodes should be evaluated before.
+		uint64_t ContentHashOf(NodeBase& nd) const {
+			uint64_t hash = HashBytes(&nd.kind, sizeof(nd.kind));
+			for (auto attrRef : nd.GetAllAttributes()) {
+				const AttributeBase& attr = attrRef.get();
+				if (attr.kind == AttributeKind::Value)
+					std::visit([&hash](auto valueRef) { hash = HashBytes(&valueRef.get(), sizeof(valueRef.get()), hash); },
+						static_cast<const ValueAttribute&>(attr).value);
+				else if (attr.kind == AttributeKind::ObjectInput) {
+					const int linkId = GetIncomingLink(attr.id);
+					const uint64_t upstreamHash = linkId == -1 ? 0 : nodes.at(attributes.at(links.at(linkId).startAttrId).get().nodeId)->contentHash;
+					hash = HashBytes(&upstreamHash, sizeof(upstreamHash), hash);
+				}
+			}
+			return hash != 0 ? hash : 1;
+		}
+
+		// Returns false if the content of node didn't change since its last evaluation
+		template <typename TEvaluate>
+		bool EvaluateIfChanged(NodeBase& nd, TEvaluate& evaluateNode) const {
+			const uint64_t hash = ContentHashOf(nd);
+			if (hash == nd.contentHash)
+				return false;
+			nd.contentHash = hash;
+			evaluateNode(nd);
+			return true;
+		}
+
+		void RecordEvaluation(const EvaluationPlan& plan, size_t numEvaluated, size_t numReused) {
+			++evaluationStats.numEvaluations;
+			evaluationStats.lastNumDirty = plan.numDirty;
+			evaluationStats.lastNumEvaluated = numEvaluated;
+			evaluationStats.lastNumReused = numReused;
+			evaluationStats.totalNumEvaluated += numEvaluated;
+			evaluationStats.totalNumReused += numReused;
+		}
+
+		AttributeLinks& LinksOf(int attrId) {
+			assert(attributes.contains(attrId));
+			const uint32_t slotIx = decltype(attributes)::IndexOf(attrId);
+			if (slotIx >= attributeLinks.size())
+				attributeLinks.resize(slotIx + 1);
+			return attributeLinks[slotIx];
+		}
 	};
 
 	// ----------------
@@ -110,6 +393,7 @@ namespace ne {
 		static Graph MakeTestGraph();
 	public:
 		Graph graph{};
+		NodeDetailThresholds detailThresholds{};
 
 	private:
 		ImNodesEditorContext* context = ImNodes::EditorContextCreate();
@@ -118,5 +402,6 @@ namespace ne {
 		void DrawNodesAndLinks();
 		void SaveLoadGraph();
 		void CreateDeleteLinks();
+		void DeleteSelectedNodes();
 	};
 }
\ No newline at end of file
@@ -5,23 +5,45 @@
 #include <string>
 
 namespace ne {
-	void NodeBase::Draw() {
+	bool NodeBase::Draw(const NodeDetailThresholds& thresholds) {
+		const float onScreenWidth = nodeWidth * ImNodes::EditorContextGetZoom();
+		const bool drawAsBox = onScreenWidth < thresholds.boxWidth;
+
+		if (drawAsBox) {
+			// Color the whole node like a title bar. Colors are read in BeginNode.
+			const ImNodesStyle& style = ImNodes::GetStyle();
+			ImNodes::PushColorStyle(ImNodesCol_NodeBackground, style.Colors[ImNodesCol_TitleBar]);
+			ImNodes::PushColorStyle(ImNodesCol_NodeBackgroundHovered, style.Colors[ImNodesCol_TitleBarHovered]);
+			ImNodes::PushColorStyle(ImNodesCol_NodeBackgroundSelected, style.Colors[ImNodesCol_TitleBarSelected]);
+		}
 		ImNodes::BeginNode(id);
 
-		ImNodes::BeginNodeTitleBar();
-		ImGui::TextUnformatted(title.c_str());
-		ImNodes::EndNodeTitleBar();
+		if (drawAsBox) {
+			ImNodes::PopColorStyle();
+			ImNodes::PopColorStyle();
+			ImNodes::PopColorStyle();
+		}
+		else {
+			ImNodes::BeginNodeTitleBar();
+			ImGui::TextUnformatted(title.c_str());
+			ImNodes::EndNodeTitleBar();
+		}
 
-		DrawContent();
+		bool edited{ false };
+		if (onScreenWidth < thresholds.titleOnlyWidth)
+			DrawPins();
+		else
+			edited = DrawContent();
 		ImNodes::EndNode();
 
-		const std::string label = std::to_string(id) + "NodePopup";
+		const char* label = FrameArena::Get().Format("%dNodePopup", id);
 		if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
-			ImGui::OpenPopup(label.c_str());
-		if (ImGui::BeginPopup(label.c_str())) {
+			ImGui::OpenPopup(label);
+		if (ImGui::BeginPopup(label)) {
 			ImGui::InputText("rename", &title);
 			ImGui::EndPopup();
 		}
+		return edited;
 	}
 
 	// -------
@@ -36,9 +58,9 @@ namespace ne {
 
 	void ObjectViewerNode::Drawer::operator()(VkAttachmentDescription& obj) {
 		ImGui::Text("MyStruct");
-		ImGui::Text("flags: %s", enums::GetFlagLabel(obj.flags).c_str());
+		ImGui::Text("flags: %s", enums::GetFlagLabel(obj.flags));
 		ImGui::Text("format: %s", enums::GetEnumLabel(obj.format));
-		ImGui::Text("samples: %s", enums::GetFlagLabel(obj.samples).c_str());
+		ImGui::Text("samples: %s", enums::GetFlagLabel(obj.samples));
 		ImGui::Text("load op: %s", enums::GetEnumLabel(obj.loadOp));
 		ImGui::Text("store op: %s", enums::GetEnumLabel(obj.storeOp));
 		ImGui::Text("stencil load op: %s", enums::GetEnumLabel(obj.stencilLoadOp));
@@ -51,10 +73,10 @@ namespace ne {
 		ImGui::Text("YourStruct");
 		ImGui::Text("num: %d", obj.num);
 		ImGui::Text("magnitude: %f", obj.magnitude);
-		ImGui::Text("color components: %s", enums::GetFlagLabel(obj.colorComponents).c_str());
+		ImGui::Text("color components: %s", enums::GetFlagLabel(obj.colorComponents));
 	}
 
-	void ObjectViewerNode::DrawContent() const {
+	bool ObjectViewerNode::DrawContent() const {
 		ImNodes::BeginInputAttribute(input.id);
 		ImGui::Text(input.name.c_str());
 		input.Draw();
@@ -66,10 +88,46 @@ namespace ne {
 		else {
 			ImGui::Text("no input");
 		}
+		return false;
+	}
+
+	void ObjectViewerNode::DrawPins() const {
+		ImNodes::BeginInputAttribute(input.id);
+		ImGui::Dummy(ImVec2{ nodeWidth * ImNodes::EditorContextGetZoom(), ImGui::GetFrameHeight() });
+		ImNodes::EndInputAttribute();
 	}
 
 	std::vector<std::reference_wrapper<AttributeBase>> ObjectViewerNode::GetAllAttributes() {
 		std::vector<std::reference_wrapper<AttributeBase>> attrs = { input };
 		return attrs;
 	}
-}
\ No newline at end of file
+
+	// -------
+
+	bool RenderPassNode::DrawContent() const {
+		for (const ObjectInputAttribute* attr : { &colorInput, &depthInput }) {
+			ImNodes::BeginInputAttribute(attr->id);
+			ImGui::TextUnformatted(attr->name.c_str());
+			ImNodes::EndInputAttribute();
+		}
+		ImGui::PushTextWrapPos(ImGui::GetCursorPosX() + nodeWidth * ImNodes::EditorContextGetZoom());
+		ImGui::TextUnformatted(status);
+		ImGui::PopTextWrapPos();
+		return false;
+	}
+
+	void RenderPassNode::DrawPins() const {
+		const ImVec2 rowSize{ nodeWidth * ImNodes::EditorContextGetZoom(), ImGui::GetFrameHeight() };
+		ImNodes::BeginInputAttribute(colorInput.id);
+		ImGui::Dummy(ImVec2{ 0.0f, rowSize.y });
+		ImNodes::EndInputAttribute();
+		ImGui::SameLine(0.0f, 0.0f);
+		ImNodes::BeginInputAttribute(depthInput.id);
+		ImGui::Dummy(ImVec2{ rowSize.x, rowSize.y });
+		ImNodes::EndInputAttribute();
+	}
+
+	std::vector<std::reference_wrapper<AttributeBase>> RenderPassNode::GetAllAttributes() {
+		return { colorInput, depthInput };
+	}
+}
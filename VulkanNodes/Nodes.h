@@ -4,25 +4,50 @@
 
 #include "dependencies/imnodes.h"
 
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace ne {
+	// On-screen node widths below which nodes are drawn with less detail
+	struct NodeDetailThresholds {
+		// only the title bar and the pins
+		float titleOnlyWidth{ 120.0f };
+		// a box in the title bar color, with the pins
+		float boxWidth{ 40.0f };
+	};
+
+	// Closed set of concrete node classes, e.g. to know which one to construct when loading a saved graph
+	enum class NodeKind : uint8_t {
+		AttachmentDescriptionEditor,
+		YourStructEditor,
+		Viewer,
+		RenderPass,
+		Count,
+	};
+
 	class NodeBase {
 	public:
 		// Members required by ImNodes
 		int id{ -1 };
 		std::string title;
+		const NodeKind kind;
 
 		const float nodeWidth{ 200 };
+		// Hash of what the node was last evaluated from, 0 if it was never evaluated. See Graph::ContentHashOf.
+		uint64_t contentHash{ 0 };
 
 		// Note that, when virtual Draw method is added to NodeBase it is not an aggregate class anymore
 		// hence it cannot be aggregate initialized, i.e. NodeBase { -1, "title" } implicit constructor cease to exist
-		NodeBase(std::string title)
-			: title{ title } {}
+		NodeBase(std::string title, NodeKind kind)
+			: title{ title }, kind{ kind } {}
 
-		void Draw();
+		// Returns whether a value of the node was edited
+		bool Draw(const NodeDetailThresholds& thresholds);
 
-		virtual void DrawContent() const = 0;
+		virtual bool DrawContent() const = 0;
+		// Submits only the pins of the node, on a single row with no widgets
+		virtual void DrawPins() const = 0;
 
 		// helper to assign unique Ids to every attribute of a node, and for graph to keep references to attributes
 		virtual std::vector<std::reference_wrapper<AttributeBase>> GetAllAttributes() = 0;
@@ -31,6 +56,16 @@ namespace ne {
 	template<typename T>
 	concept IsNode = std::is_base_of<NodeBase, T>::value;
 
+	template <typename TObj>
+	constexpr NodeKind ObjectEditorNodeKind() {
+		if constexpr (std::is_same_v<TObj, VkAttachmentDescription>)
+			return NodeKind::AttachmentDescriptionEditor;
+		else if constexpr (std::is_same_v<TObj, YourStruct>)
+			return NodeKind::YourStructEditor;
+		else
+			static_assert(!sizeof(TObj), "no NodeKind for this object type");
+	}
+
 	template <typename TObj>
 	class ObjectEditorNode : public NodeBase {
 	public:
@@ -43,33 +78,35 @@ namespace ne {
 
 		// initialize a default object
 		ObjectEditorNode(std::string title)
-			: NodeBase{ title }, object{}, output{ object } {
+			: NodeBase{ title, ObjectEditorNodeKind<TObj>() }, object{}, output{ object } {
 			AddInputs(object);
 		}
 
 		// construct an object with given arguments
 		template<typename... Args>
 		ObjectEditorNode(std::string title, Args... args)
-			: NodeBase{ title }, object{ args... }, output{ object } {
+			: NodeBase{ title, ObjectEditorNodeKind<TObj>() }, object{ args... }, output{ object } {
 			AddInputs(object);
 		}
 
 		// move provided object
 		ObjectEditorNode(std::string title, TObj&& obj)
-			: NodeBase{ title }, object{ std::move(obj) }, output{ object } {
+			: NodeBase{ title, ObjectEditorNodeKind<TObj>() }, object{ std::move(obj) }, output{ object } {
 			AddInputs(object);
 		}
 
-		void DrawContent() const override {
+		bool DrawContent() const override {
+			const float width{ nodeWidth * ImNodes::EditorContextGetZoom() };
+			bool edited{ false };
 			for (const auto& attr : inputs) {
 				ImNodes::BeginInputAttribute(attr.id);
 				const float labelWidth{ ImGui::CalcTextSize(attr.name.c_str()).x };
 				ImGui::TextUnformatted(attr.name.c_str());
 
 				ImGui::SameLine();
-				ImGui::PushItemWidth(nodeWidth - labelWidth);
+				ImGui::PushItemWidth(width - labelWidth);
 
-				attr.Draw();
+				edited |= attr.Draw();
 
 				ImGui::PopItemWidth();
 				ImNodes::EndInputAttribute();
@@ -79,10 +116,25 @@ namespace ne {
 				const auto& attr{ output };
 				ImNodes::BeginOutputAttribute(attr.id);
 				const float labelWidth{ ImGui::CalcTextSize(attr.name.c_str()).x };
-				ImGui::Indent(nodeWidth - labelWidth);
+				ImGui::Indent(width - labelWidth);
 				ImGui::Text(attr.name.c_str());
 				ImNodes::EndOutputAttribute();
 			}
+			return edited;
+		}
+
+		void DrawPins() const override {
+			// Input pins are stacked at the start of the row, the output pin spans all of it
+			const ImVec2 rowSize{ nodeWidth * ImNodes::EditorContextGetZoom(), ImGui::GetFrameHeight() };
+			for (const auto& attr : inputs) {
+				ImNodes::BeginInputAttribute(attr.id);
+				ImGui::Dummy(ImVec2{ 0.0f, rowSize.y });
+				ImNodes::EndInputAttribute();
+				ImGui::SameLine(0.0f, 0.0f);
+			}
+			ImNodes::BeginOutputAttribute(output.id);
+			ImGui::Dummy(rowSize);
+			ImNodes::EndOutputAttribute();
 		}
 
 		std::vector<std::reference_wrapper<AttributeBase>> GetAllAttributes() override {
@@ -116,7 +168,7 @@ namespace ne {
 	public:
 		ObjectInputAttribute input;
 
-		ObjectViewerNode() : NodeBase{ "Viewer" } {}
+		ObjectViewerNode() : NodeBase{ "Viewer", NodeKind::Viewer } {}
 
 		struct Drawer {
 			void operator()(float& val);
@@ -125,8 +177,30 @@ namespace ne {
 			void operator()(YourStruct& obj);
 		};
 
-		void DrawContent() const override;
+		bool DrawContent() const override;
+		void DrawPins() const override;
+
+		std::vector<std::reference_wrapper<AttributeBase>> GetAllAttributes() override;
+	};
+
+	// Attachments of a render pass with a single subpass. GraphCompiler turns it into a VkRenderPass and a pipeline for it.
+	class RenderPassNode : public NodeBase {
+	public:
+		ObjectInputAttribute colorInput{ "color", ObjectTypeBit<VkAttachmentDescription>() };
+		// optional
+		ObjectInputAttribute depthInput{ "depth", ObjectTypeBit<VkAttachmentDescription>() };
+
+		// Set by GraphCompiler. Objects are owned by its cache, and are VK_NULL_HANDLE if inputs don't make a valid render pass.
+		VkRenderPass renderPass{ VK_NULL_HANDLE };
+		VkPipeline pipeline{ VK_NULL_HANDLE };
+		// how the objects were made, or why they couldn't be
+		const char* status{ "not compiled" };
+
+		RenderPassNode() : NodeBase{ "RenderPass", NodeKind::RenderPass } {}
+
+		bool DrawContent() const override;
+		void DrawPins() const override;
 
 		std::vector<std::reference_wrapper<AttributeBase>> GetAllAttributes() override;
 	};
-}
\ No newline at end of file
+}
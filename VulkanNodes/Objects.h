@@ -1,51 +1,105 @@
 #pragma once
 
+#include "FrameArena.h"
+
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <map>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <type_traits>
 
 namespace ne {
 
 	namespace enums {
+		template <typename TVkEnum>
+		struct EnumLabel {
+			TVkEnum value;
+			const char* label;
+		};
+
+		// Labels of the values of an enum, iterated in order of values. Built at compile time, no static initialization.
+		// Lookup is a single probe: value % modulus indexes the position of value, modulus being the smallest one without collisions.
+		template <typename TVkEnum, size_t N>
+		class EnumDict {
+		public:
+			static constexpr uint32_t maxModulus{ 64 };
+
+			consteval EnumDict(const std::array<EnumLabel<TVkEnum>, N>& labels) : labels{ labels } {
+				for (size_t ix = 1; ix < N; ++ix)
+					if (Key(labels[ix - 1].value) >= Key(labels[ix].value))
+						NotAConstant(); // labels have to be sorted by value, without duplicates
+				for (modulus = std::max<uint32_t>(static_cast<uint32_t>(N), 1); modulus <= maxModulus; ++modulus) {
+					slots.fill(static_cast<uint8_t>(N));
+					bool collided = false;
+					for (size_t ix = 0; ix < N && !collided; ++ix) {
+						uint8_t& slot = slots[Key(labels[ix].value) % modulus];
+						collided = slot != N;
+						slot = static_cast<uint8_t>(ix);
+					}
+					if (!collided)
+						return;
+				}
+				NotAConstant(); // no modulus up to maxModulus
+			}
+
+			constexpr const EnumLabel<TVkEnum>* begin() const { return labels.data(); }
+			constexpr const EnumLabel<TVkEnum>* end() const { return labels.data() + N; }
+
+			// nullptr if value has no label
+			constexpr const char* Find(TVkEnum value) const {
+				const uint8_t ix = slots[Key(value) % modulus];
+				return ix < N && labels[ix].value == value ? labels[ix].label : nullptr;
+			}
+		private:
+			std::array<EnumLabel<TVkEnum>, N> labels;
+			uint32_t modulus{ 0 };
+			std::array<uint8_t, maxModulus> slots{};
+
+			static constexpr uint32_t Key(TVkEnum value) { return static_cast<uint32_t>(value); }
+			// Not constexpr, hence calling it while building a dict fails compilation
+			static void NotAConstant() {}
+		};
+
 		// ENUMS
 
-		static std::map<VkAttachmentLoadOp, const char*> VkAttachmentLoadOpDict = {
+		inline constexpr EnumDict VkAttachmentLoadOpDict{ std::to_array<EnumLabel<VkAttachmentLoadOp>>({
 			{VK_ATTACHMENT_LOAD_OP_LOAD, "Load"},
 			{VK_ATTACHMENT_LOAD_OP_CLEAR, "Clear"},
 			{VK_ATTACHMENT_LOAD_OP_DONT_CARE, "Don't Care"},
 			{VK_ATTACHMENT_LOAD_OP_NONE_EXT, "None Ext"},
-		};
+		}) };
 
-		static std::map<VkAttachmentStoreOp, const char*> VkAttachmentStoreOpDict = {
+		inline constexpr EnumDict VkAttachmentStoreOpDict{ std::to_array<EnumLabel<VkAttachmentStoreOp>>({
 			{VK_ATTACHMENT_STORE_OP_STORE, "Store"},
 			{VK_ATTACHMENT_STORE_OP_DONT_CARE, "Don't Care"},
 			{VK_ATTACHMENT_STORE_OP_NONE_EXT, "None Ext"},
-		};
+		}) };
 
-		static std::map<VkFormat, const char*> VkFormatOpDict = {
+		inline constexpr EnumDict VkFormatOpDict{ std::to_array<EnumLabel<VkFormat>>({
 			{VK_FORMAT_UNDEFINED, "Undefined"},
-			{VK_FORMAT_D24_UNORM_S8_UINT, "D24 Unorm S8 Uint"},
-			{VK_FORMAT_R32G32B32_SFLOAT, "R32G32B32 Sfloat"},
-			{VK_FORMAT_B8G8R8A8_SRGB, "B8G8R8A8 Srgb"},
 			{VK_FORMAT_R8G8B8A8_UNORM, "R8G8B8A8 Unorm"},
 			{VK_FORMAT_R8G8B8A8_SRGB, "R8G8B8A8 Srgb"},
-		};
+			{VK_FORMAT_B8G8R8A8_SRGB, "B8G8R8A8 Srgb"},
+			{VK_FORMAT_R32G32B32_SFLOAT, "R32G32B32 Sfloat"},
+			{VK_FORMAT_D24_UNORM_S8_UINT, "D24 Unorm S8 Uint"},
+		}) };
 
-		static std::map<VkImageLayout, const char*> VkImageLayoutDict = {
+		inline constexpr EnumDict VkImageLayoutDict{ std::to_array<EnumLabel<VkImageLayout>>({
 			{VK_IMAGE_LAYOUT_UNDEFINED, "Undefined"},
 			{VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, "Color Attachment Optimal"},
 			{VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, "Depth Stencil Attachment Optimal"},
-			{VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL, "Shader Read-Only Optimal"},
 			{VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, "Transfer Source Optimal"},
 			{VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, "Transfer Destination Optimal"},
-			{VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, "Depth Attachment Optimal"},
 			{VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, "Present Source Khronos"},
-		};
+			{VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, "Depth Attachment Optimal"},
+			{VK_IMAGE_LAYOUT_STENCIL_READ_ONLY_OPTIMAL, "Shader Read-Only Optimal"},
+		}) };
 
-		static std::map<VkSampleCountFlagBits, const char*> VkSampleCountDict = {
+		inline constexpr EnumDict VkSampleCountDict{ std::to_array<EnumLabel<VkSampleCountFlagBits>>({
 			{VK_SAMPLE_COUNT_1_BIT, "1"},
 			{VK_SAMPLE_COUNT_2_BIT, "2"},
 			{VK_SAMPLE_COUNT_4_BIT, "4"},
@@ -53,24 +107,24 @@ namespace ne {
 			{VK_SAMPLE_COUNT_16_BIT, "16"},
 			{VK_SAMPLE_COUNT_32_BIT, "32"},
 			{VK_SAMPLE_COUNT_64_BIT, "64"},
-		};
+		}) };
 		
 		// FLAGS
 
 		// Actually values are of type VkAttachmentDescriptionFlagBits but the struct takes VkAttachmentDescriptionFlags
-		static std::map<VkAttachmentDescriptionFlags, const char*> VkAttachmentDescriptionDict = {
+		inline constexpr EnumDict VkAttachmentDescriptionDict{ std::to_array<EnumLabel<VkAttachmentDescriptionFlags>>({
 			{VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT, "May Alias"},
-		};
+		}) };
 
-		static std::map<VkColorComponentFlagBits, const char*> VkColorComponentDict = {
+		inline constexpr EnumDict VkColorComponentDict{ std::to_array<EnumLabel<VkColorComponentFlagBits>>({
 			{VK_COLOR_COMPONENT_R_BIT, "R"},
 			{VK_COLOR_COMPONENT_G_BIT, "G"},
 			{VK_COLOR_COMPONENT_B_BIT, "B"},
 			{VK_COLOR_COMPONENT_A_BIT, "A"},
-		};
+		}) };
 
 		template <typename TVkEnum>
-		const std::map<TVkEnum, const char*>& GetDict() {
+		constexpr const auto& GetDict() {
 			if constexpr (std::is_same_v<TVkEnum, VkAttachmentLoadOp>)
 				return VkAttachmentLoadOpDict;
 			else if constexpr (std::is_same_v<TVkEnum, VkAttachmentStoreOp>)
@@ -90,21 +144,30 @@ namespace ne {
 
 		template <typename TVkEnum>
 		const char* GetEnumLabel(const TVkEnum& val) {
-			auto& dict = GetDict<TVkEnum>();
-			assert(dict.contains(val));
-			return dict.at(val);
+			const char* label = GetDict<TVkEnum>().Find(val);
+			assert(label != nullptr);
+			return label;
 		}
 
+		// Comma separated labels of the set bits. Allocated in the frame arena, valid until the end of the frame.
 		template <typename TVkFlag>
-		std::string GetFlagLabel(const TVkFlag& val) {
-			std::string label;
+		const char* GetFlagLabel(const TVkFlag& val) {
 			auto& dict = enums::GetDict<TVkFlag>();
+			size_t len = 0;
+			for (auto& [opVal, opLabel] : dict)
+				if ((opVal & val) == opVal)
+					len += std::strlen(opLabel) + 1;
+			char* label = FrameArena::Get().AllocateArray<char>(len + 1);
+			char* end = label;
 			for (auto& [opVal, opLabel] : dict) {
 				if ((opVal & val) == opVal) {
-					label += opLabel;
-					label += ",";
+					const size_t opLen = std::strlen(opLabel);
+					std::memcpy(end, opLabel, opLen);
+					end[opLen] = ',';
+					end += opLen + 1;
 				}
 			}
+			*end = '\0';
 			return label;
 		}
 	};
@@ -0,0 +1,107 @@
+#include "Profiler.h"
+#include "FrameArena.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+void Profiler::BeginFrame() {
+	const int64_t now = Now();
+	if (frameStartNs != 0)
+		AddCpuScope("frame", frameStartNs, now);
+	frameStartNs = now;
+
+	for (Track& track : tracks) {
+		track.durationsMs[historyIx] = track.frameMs;
+		track.frameMs = 0.0f;
+	}
+	historyIx = (historyIx + 1) % historySize;
+}
+
+void Profiler::AddCpuScope(const char* name, int64_t startNs, int64_t endNs) {
+	AddScope(name, false, startNs, endNs);
+}
+
+void Profiler::AddGpuScope(const char* name, int64_t startNs, int64_t endNs) {
+	AddScope(name, true, startNs, endNs);
+}
+
+void Profiler::AddScope(const char* name, bool gpu, int64_t startNs, int64_t endNs) {
+	auto it = std::find_if(tracks.begin(), tracks.end(), [&](const Track& track) { return track.name == name && track.gpu == gpu; });
+	if (it == tracks.end()) {
+		tracks.push_back({ name, gpu });
+		it = tracks.end() - 1;
+	}
+	it->frameMs += static_cast<float>(endNs - startNs) * 1e-6f;
+	if (tracing)
+		traceEvents.push_back({ name, gpu, startNs, endNs - startNs });
+}
+
+void Profiler::DrawWindow() {
+	ImGui::Begin("Profiler");
+	FrameArena& frameArena{ FrameArena::Get() };
+	for (const Track& track : tracks) {
+		float sumMs{ 0.0f };
+		float maxMs{ 0.0f };
+		for (float ms : track.durationsMs) {
+			sumMs += ms;
+			maxMs = std::max(maxMs, ms);
+		}
+		ImGui::Text("%s %s: %.3f ms avg, %.3f ms max", track.gpu ? "GPU" : "CPU", track.name, sumMs / historySize, maxMs);
+		// oldest duration first
+		ImGui::PlotHistogram(frameArena.Format("##%s%d", track.name, track.gpu), track.durationsMs.data(), static_cast<int>(historySize),
+			static_cast<int>(historyIx), nullptr, 0.0f, maxMs, ImVec2{ 0.0f, 40.0f });
+	}
+
+	if (!tracing) {
+		if (ImGui::Button("Start trace"))
+			StartTrace();
+	}
+	else {
+		const char* traceFile{ "profile_trace.json" };
+		if (ImGui::Button("Save trace"))
+			SaveTrace(traceFile);
+		ImGui::SameLine();
+		ImGui::Text("%zu events", traceEvents.size());
+	}
+	ImGui::End();
+}
+
+void Profiler::StartTrace() {
+	tracing = true;
+	traceStartNs = Now();
+	traceEvents.clear();
+}
+
+bool Profiler::SaveTrace(const std::string& path) {
+	tracing = false;
+	std::ofstream file(path);
+	if (!file.is_open())
+		return false;
+
+	// Complete events, with timestamps in microseconds. CPU and GPU are separate threads of the same process.
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+	for (const TraceEvent& event : traceEvents) {
+		// GPU events of frames before StartTrace can be reported after it
+		if (event.startNs < traceStartNs)
+			continue;
+		file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (event.gpu ? 1 : 0)
+			<< ",\"ts\":" << (event.startNs - traceStartNs) / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+	}
+	file << "\n]}\n";
+	traceEvents.clear();
+	return file.good();
+}
+
+int64_t Profiler::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler& Profiler::Get() {
+	static Profiler profiler;
+	return profiler;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Durations of named scopes over recent frames, of CPU code on the main thread and of GPU commands.
+// Names are string literals, and are told apart by their addresses.
+class Profiler {
+public:
+	static constexpr size_t historySize{ 240 };
+
+	// Called at the beginning of every frame. Durations of the previous frame go into histories.
+	void BeginFrame();
+	void AddCpuScope(const char* name, int64_t startNs, int64_t endNs);
+	// GPU scopes are reported when GPU is done with their frame, i.e. frames later. Times are on the CPU clock, see VulkanContext.
+	void AddGpuScope(const char* name, int64_t startNs, int64_t endNs);
+
+	// ImGui window with a histogram per scope, and trace controls
+	void DrawWindow();
+
+	// Scopes are kept as events from StartTrace until SaveTrace
+	void StartTrace();
+	bool IsTracing() const { return tracing; }
+	// Chrome trace event format, viewable in chrome://tracing or ui.perfetto.dev. Stops tracing.
+	bool SaveTrace(const std::string& path);
+
+	// Nanoseconds on steady clock
+	static int64_t Now();
+	static Profiler& Get();
+private:
+	struct Track {
+		const char* name;
+		bool gpu;
+		std::array<float, historySize> durationsMs{};
+		// sum over the frame being built, since a scope can run more than once in a frame
+		float frameMs{ 0.0f };
+	};
+	struct TraceEvent {
+		const char* name;
+		bool gpu;
+		int64_t startNs;
+		int64_t durationNs;
+	};
+	// Added in the first frames only, hence there are no allocations in steady state
+	std::vector<Track> tracks;
+	// slot of histories that the frame being built goes into, the oldest one
+	size_t historyIx{ 0 };
+	int64_t frameStartNs{ 0 };
+	bool tracing{ false };
+	int64_t traceStartNs{ 0 };
+	std::vector<TraceEvent> traceEvents;
+
+	void AddScope(const char* name, bool gpu, int64_t startNs, int64_t endNs);
+};
+
+// Measures time until the end of the C++ scope. Main thread only.
+class ProfileScope {
+public:
+	ProfileScope(const char* name) : name{ name }, startNs{ Profiler::Now() } {}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+	~ProfileScope() { Profiler::Get().AddCpuScope(name, startNs, Profiler::Now()); }
+private:
+	const char* name;
+	int64_t startNs;
+};
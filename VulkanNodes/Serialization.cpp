@@ -0,0 +1,827 @@
+#include "Serialization.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ne {
+	static_assert(std::is_trivially_copyable_v<VkAttachmentDescription> && std::is_trivially_copyable_v<YourStruct>);
+	static_assert(sizeof(file::NodeRecord) % 4 == 0 && sizeof(file::LinkRecord) % 4 == 0);
+
+	namespace {
+		// Read-only view of a whole file
+		class MappedFile {
+		public:
+			const uint8_t* data{};
+			size_t size{};
+
+			MappedFile(const std::string& path) {
+#ifdef _WIN32
+				file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (file == INVALID_HANDLE_VALUE)
+					return;
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+					return;
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping == nullptr)
+					return;
+				const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if (view == nullptr)
+					return;
+				data = static_cast<const uint8_t*>(view);
+				size = static_cast<size_t>(fileSize.QuadPart);
+#else
+				fd = open(path.c_str(), O_RDONLY);
+				if (fd == -1)
+					return;
+				struct stat st;
+				if (fstat(fd, &st) == -1 || st.st_size == 0)
+					return;
+				void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (view == MAP_FAILED)
+					return;
+				data = static_cast<const uint8_t*>(view);
+				size = static_cast<size_t>(st.st_size);
+#endif
+			}
+
+			~MappedFile() {
+#ifdef _WIN32
+				if (data != nullptr)
+					UnmapViewOfFile(data);
+				if (mapping != nullptr)
+					CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE)
+					CloseHandle(file);
+#else
+				if (data != nullptr)
+					munmap(const_cast<uint8_t*>(data), size);
+				if (fd != -1)
+					close(fd);
+#endif
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+		private:
+#ifdef _WIN32
+			HANDLE file{ INVALID_HANDLE_VALUE };
+			HANDLE mapping{ nullptr };
+#else
+			int fd{ -1 };
+#endif
+		};
+
+		template <typename TObj>
+		void CopyObjectTo(const NodeBase& nd, file::NodeRecord& rec) {
+			const TObj& obj = static_cast<const ObjectEditorNode<TObj>&>(nd).object;
+			std::memcpy(rec.object, &obj, sizeof(TObj));
+		}
+
+		template <typename TObj>
+		std::shared_ptr<NodeBase> MakeObjectEditorNode(const file::NodeRecord& rec, std::string title) {
+			TObj obj;
+			std::memcpy(&obj, rec.object, sizeof(TObj));
+			return std::make_shared<ObjectEditorNode<TObj>>(std::move(title), std::move(obj));
+		}
+
+		template <typename T>
+		constexpr bool isFlagType = std::is_same_v<T, VkColorComponentFlagBits> || std::is_same_v<T, VkAttachmentDescriptionFlags>;
+
+		// Value attributes of an editor node, i.e. the members of its object
+		std::vector<ValueAttribute>* GetValueAttributes(NodeBase& nd) {
+			switch (nd.kind) {
+			case NodeKind::AttachmentDescriptionEditor:
+				return &static_cast<ObjectEditorNode<VkAttachmentDescription>&>(nd).inputs;
+			case NodeKind::YourStructEditor:
+				return &static_cast<ObjectEditorNode<YourStruct>&>(nd).inputs;
+			default:
+				return nullptr;
+			}
+		}
+
+		// Whether an enum member of an editor node has a value without a label in ne::enums, which the UI cannot show
+		bool HasUnlabeledValue(NodeBase& nd) {
+			const std::vector<ValueAttribute>* values = GetValueAttributes(nd);
+			if (values == nullptr)
+				return false;
+			for (const ValueAttribute& attr : *values) {
+				const bool isLabeled = std::visit([](auto valueRef) {
+					using T = typename decltype(valueRef)::type;
+					if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float> || isFlagType<T>)
+						return true;
+					else
+						return enums::GetDict<T>().Find(valueRef.get()) != nullptr;
+					}, attr.value);
+				if (!isLabeled)
+					return true;
+			}
+			return false;
+		}
+
+		// Gives saved ids to the attributes of a node that is about to be added to graph. Returns an error, if any.
+		const char* SetAttributeIds(const Graph& graph, NodeBase& nd, const int32_t* ids, size_t count) {
+			const auto attrs = nd.GetAllAttributes();
+			if (attrs.size() != count)
+				return "attribute count does not match node kind";
+			for (size_t j = 0; j < count; ++j) {
+				if (!graph.attributes.is_free(ids[j]))
+					return "invalid attribute id";
+				for (size_t k = 0; k < j; ++k)
+					if (decltype(graph.attributes)::IndexOf(ids[k]) == decltype(graph.attributes)::IndexOf(ids[j]))
+						return "invalid attribute id";
+				attrs[j].get().id = ids[j];
+			}
+			return nullptr;
+		}
+
+		bool Fail(const std::string& path, const char* reason) {
+			std::cerr << "Cannot load graph from " << path << ": " << reason << std::endl;
+			return false;
+		}
+	}
+
+	bool SaveGraph(const std::string& path, const Graph& graph, const std::function<ImVec2(int nodeId)>& getNodePos) {
+		std::vector<file::NodeRecord> nodeRecords;
+		std::vector<int32_t> attributeIds;
+		std::vector<file::LinkRecord> linkRecords;
+		std::string strings;
+		nodeRecords.reserve(graph.nodes.size());
+		attributeIds.reserve(graph.attributes.size());
+		linkRecords.reserve(graph.links.size());
+
+		for (const std::shared_ptr<NodeBase>& ndPtr : graph.nodes) {
+			NodeBase& nd = *ndPtr;
+			file::NodeRecord rec{};
+			rec.id = nd.id;
+			rec.kind = nd.kind;
+			const ImVec2 pos = getNodePos(nd.id);
+			rec.posX = pos.x;
+			rec.posY = pos.y;
+			rec.titleOffset = static_cast<uint32_t>(strings.size());
+			rec.titleSize = static_cast<uint32_t>(nd.title.size());
+			strings += nd.title;
+
+			rec.firstAttribute = static_cast<uint32_t>(attributeIds.size());
+			for (auto attrRef : nd.GetAllAttributes())
+				attributeIds.push_back(attrRef.get().id);
+			rec.numAttributes = static_cast<uint32_t>(attributeIds.size()) - rec.firstAttribute;
+
+			switch (nd.kind) {
+			case NodeKind::AttachmentDescriptionEditor:
+				CopyObjectTo<VkAttachmentDescription>(nd, rec);
+				break;
+			case NodeKind::YourStructEditor:
+				CopyObjectTo<YourStruct>(nd, rec);
+				break;
+			case NodeKind::Viewer:
+			case NodeKind::RenderPass:
+				break;
+			default:
+				assert(false); // unknown node kind
+			}
+			nodeRecords.push_back(rec);
+		}
+
+		for (const Link& link : graph.links)
+			linkRecords.push_back({ link.startAttrId, link.endAttrId });
+
+		file::Header header{};
+		std::memcpy(header.magic, file::magic, sizeof(header.magic));
+		header.version = file::version;
+		header.numNodes = static_cast<uint32_t>(nodeRecords.size());
+		header.numAttributes = static_cast<uint32_t>(attributeIds.size());
+		header.numLinks = static_cast<uint32_t>(linkRecords.size());
+		header.stringsSize = static_cast<uint32_t>(strings.size());
+
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(nodeRecords.data()), nodeRecords.size() * sizeof(file::NodeRecord));
+		out.write(reinterpret_cast<const char*>(attributeIds.data()), attributeIds.size() * sizeof(int32_t));
+		out.write(reinterpret_cast<const char*>(linkRecords.data()), linkRecords.size() * sizeof(file::LinkRecord));
+		out.write(strings.data(), strings.size());
+		return out.good();
+	}
+
+	bool LoadGraph(const std::string& path, Graph& graph, const std::function<void(int nodeId, ImVec2 pos)>& setNodePos) {
+		const MappedFile mapped{ path };
+		if (mapped.data == nullptr)
+			return Fail(path, "cannot map file");
+		if (mapped.size < sizeof(file::Header))
+			return Fail(path, "file too small");
+
+		const auto* header = reinterpret_cast<const file::Header*>(mapped.data);
+		if (std::memcmp(header->magic, file::magic, sizeof(file::magic)) != 0)
+			return Fail(path, "not a graph file");
+		if (header->version != file::version)
+			return Fail(path, "unsupported version");
+		const uint64_t expectedSize = sizeof(file::Header)
+			+ uint64_t{ header->numNodes } * sizeof(file::NodeRecord)
+			+ uint64_t{ header->numAttributes } * sizeof(int32_t)
+			+ uint64_t{ header->numLinks } * sizeof(file::LinkRecord)
+			+ header->stringsSize;
+		if (mapped.size != expectedSize)
+			return Fail(path, "size does not match header");
+
+		// All sections have 4-byte aligned records, and the mapping is page aligned
+		const auto* nodeRecords = reinterpret_cast<const file::NodeRecord*>(mapped.data + sizeof(file::Header));
+		const auto* attributeIds = reinterpret_cast<const int32_t*>(nodeRecords + header->numNodes);
+		const auto* linkRecords = reinterpret_cast<const file::LinkRecord*>(attributeIds + header->numAttributes);
+		const auto* strings = reinterpret_cast<const char*>(linkRecords + header->numLinks);
+
+		Graph loaded{};
+		loaded.nodes.reserve(header->numNodes);
+		loaded.attributes.reserve(header->numAttributes);
+		loaded.links.reserve(header->numLinks);
+
+		for (uint32_t i = 0; i < header->numNodes; ++i) {
+			const file::NodeRecord& rec = nodeRecords[i];
+			if (uint64_t{ rec.titleOffset } + rec.titleSize > header->stringsSize
+				|| uint64_t{ rec.firstAttribute } + rec.numAttributes > header->numAttributes)
+				return Fail(path, "node refers outside of the file");
+			if (!loaded.nodes.is_free(rec.id))
+				return Fail(path, "invalid node id");
+
+			std::string title{ strings + rec.titleOffset, rec.titleSize };
+			std::shared_ptr<NodeBase> nd;
+			switch (rec.kind) {
+			case NodeKind::AttachmentDescriptionEditor:
+				nd = MakeObjectEditorNode<VkAttachmentDescription>(rec, std::move(title));
+				break;
+			case NodeKind::YourStructEditor:
+				nd = MakeObjectEditorNode<YourStruct>(rec, std::move(title));
+				break;
+			case NodeKind::Viewer:
+				nd = std::make_shared<ObjectViewerNode>();
+				nd->title = std::move(title);
+				break;
+			case NodeKind::RenderPass:
+				nd = std::make_shared<RenderPassNode>();
+				nd->title = std::move(title);
+				break;
+			default:
+				return Fail(path, "unknown node kind");
+			}
+			if (HasUnlabeledValue(*nd))
+				return Fail(path, "enum value without a label");
+			nd->id = rec.id;
+			if (const char* error = SetAttributeIds(loaded, *nd, attributeIds + rec.firstAttribute, rec.numAttributes))
+				return Fail(path, error);
+			loaded.AddNode(nd);
+		}
+
+		for (uint32_t i = 0; i < header->numLinks; ++i) {
+			const file::LinkRecord& rec = linkRecords[i];
+			if (!loaded.attributes.contains(rec.startAttrId) || !loaded.attributes.contains(rec.endAttrId))
+				return Fail(path, "link refers to a missing attribute");
+			if (loaded.AddLink(rec.startAttrId, rec.endAttrId) == -1)
+				return Fail(path, "link between attributes that cannot be linked");
+		}
+
+		graph = std::move(loaded);
+		for (uint32_t i = 0; i < header->numNodes; ++i)
+			setNodePos(nodeRecords[i].id, ImVec2{ nodeRecords[i].posX, nodeRecords[i].posY });
+		return true;
+	}
+}
+
+// ---------------- JSON
+
+namespace ne {
+	namespace {
+		const char* nodeKindNames[] = { "AttachmentDescriptionEditor", "YourStructEditor", "Viewer", "RenderPass" };
+		static_assert(std::size(nodeKindNames) == static_cast<size_t>(NodeKind::Count));
+
+		class JsonWriter {
+		public:
+			std::string out;
+
+			void String(std::string_view str) {
+				out += '"';
+				for (const char c : str) {
+					if (c == '"' || c == '\\') {
+						out += '\\';
+						out += c;
+					}
+					else if (static_cast<unsigned char>(c) < 0x20) {
+						char buf[8];
+						std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+						out += buf;
+					}
+					else
+						out += c;
+				}
+				out += '"';
+			}
+
+			template <typename TNumber>
+			void Number(TNumber val) {
+				// shortest representation that parses back to the same value
+				char buf[32];
+				const auto result = std::to_chars(buf, buf + sizeof(buf), val);
+				out.append(buf, result.ptr);
+			}
+
+			// Visitor that writes a ValueAttribute. Enums and flags are written with their labels in ne::enums.
+			template <typename T>
+			void operator()(std::reference_wrapper<T> ref) {
+				const T& val = ref.get();
+				if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>)
+					Number(val);
+				else if constexpr (isFlagType<T>) {
+					out += '[';
+					const char* separator = "";
+					auto remaining = val;
+					for (auto& [opVal, opLabel] : enums::GetDict<T>()) {
+						if ((opVal & val) == opVal) {
+							out += separator;
+							String(opLabel);
+							separator = ", ";
+							remaining = static_cast<T>(remaining & ~opVal);
+						}
+					}
+					// bits without a label are kept as a number
+					if (remaining != 0) {
+						out += separator;
+						Number(static_cast<uint32_t>(remaining));
+					}
+					out += ']';
+				}
+				else {
+					if (const char* label = enums::GetDict<T>().Find(val))
+						String(label);
+					else
+						Number(static_cast<int32_t>(val));
+				}
+			}
+		};
+
+		// Pull parser over a JSON text. Strings are views into the text unless they have escapes.
+		// A syntax error makes every following call fail, so that callers can check once per record.
+		class JsonReader {
+		public:
+			JsonReader(const char* begin, const char* end) : cur{ begin }, end{ end } {}
+
+			bool Ok() const { return ok; }
+			bool AtEnd() {
+				SkipWhitespace();
+				return cur == end;
+			}
+
+			char Peek() {
+				SkipWhitespace();
+				return cur != end ? *cur : '\0';
+			}
+
+			bool Expect(char c) {
+				if (Peek() != c)
+					return Error();
+				++cur;
+				return true;
+			}
+
+			// Iterates members of an object: call BeginObject, then NextMember until it returns false
+			bool BeginObject() {
+				first = true;
+				return Expect('{');
+			}
+			bool NextMember(std::string_view& key) {
+				if (!ok)
+					return false;
+				if (Peek() == '}') {
+					++cur;
+					first = false;
+					return false;
+				}
+				if (!first && !Expect(','))
+					return false;
+				first = false;
+				return String(key) && Expect(':');
+			}
+
+			// Iterates elements of an array: call BeginArray, then NextElement until it returns false
+			bool BeginArray() {
+				first = true;
+				return Expect('[');
+			}
+			bool NextElement() {
+				if (!ok)
+					return false;
+				if (Peek() == ']') {
+					++cur;
+					first = false;
+					return false;
+				}
+				if (!first && !Expect(','))
+					return false;
+				first = false;
+				return true;
+			}
+
+			bool String(std::string_view& str) {
+				if (!Expect('"'))
+					return false;
+				const char* begin = cur;
+				while (cur != end && *cur != '"' && *cur != '\\')
+					++cur;
+				if (cur != end && *cur == '"') {
+					str = std::string_view{ begin, static_cast<size_t>(cur - begin) };
+					++cur;
+					return true;
+				}
+				// has escapes, unescape into scratch
+				scratch.assign(begin, cur);
+				while (cur != end && *cur != '"') {
+					if (*cur != '\\') {
+						scratch += *cur++;
+						continue;
+					}
+					if (++cur == end)
+						return Error();
+					switch (*cur++) {
+					case '"': scratch += '"'; break;
+					case '\\': scratch += '\\'; break;
+					case '/': scratch += '/'; break;
+					case 'b': scratch += '\b'; break;
+					case 'f': scratch += '\f'; break;
+					case 'n': scratch += '\n'; break;
+					case 'r': scratch += '\r'; break;
+					case 't': scratch += '\t'; break;
+					case 'u': {
+						uint32_t code;
+						if (end - cur < 4 || std::from_chars(cur, cur + 4, code, 16).ptr != cur + 4)
+							return Error();
+						cur += 4;
+						// UTF-8 encode, surrogate pairs are not combined
+						if (code < 0x80)
+							scratch += static_cast<char>(code);
+						else if (code < 0x800) {
+							scratch += static_cast<char>(0xC0 | (code >> 6));
+							scratch += static_cast<char>(0x80 | (code & 0x3F));
+						}
+						else {
+							scratch += static_cast<char>(0xE0 | (code >> 12));
+							scratch += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+							scratch += static_cast<char>(0x80 | (code & 0x3F));
+						}
+						break;
+					}
+					default:
+						return Error();
+					}
+				}
+				if (cur == end)
+					return Error();
+				++cur;
+				str = scratch;
+				return true;
+			}
+
+			template <typename TNumber>
+			bool Number(TNumber& val) {
+				SkipWhitespace();
+				const auto result = std::from_chars(cur, end, val);
+				if (result.ec != std::errc{})
+					return Error();
+				cur = result.ptr;
+				return true;
+			}
+
+			// Skips a value of any type, e.g. of an unknown member
+			bool Skip() {
+				std::string_view str;
+				switch (Peek()) {
+				case '"':
+					return String(str);
+				case '{':
+					BeginObject();
+					while (NextMember(str))
+						Skip();
+					return ok;
+				case '[':
+					BeginArray();
+					while (NextElement())
+						Skip();
+					return ok;
+				default:
+					// number, true, false, null
+					while (cur != end && (std::isalnum(static_cast<unsigned char>(*cur)) || *cur == '-' || *cur == '+' || *cur == '.'))
+						++cur;
+					return ok;
+				}
+			}
+
+			bool Error() {
+				ok = false;
+				cur = end;
+				return false;
+			}
+
+		private:
+			const char* cur;
+			const char* end;
+			bool ok{ true };
+			// whether next member or element is the first one of its object or array
+			bool first{};
+			std::string scratch;
+
+			void SkipWhitespace() {
+				while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t'))
+					++cur;
+			}
+		};
+
+		// Visitor that reads a ValueAttribute written by JsonWriter
+		struct JsonValueReader {
+			JsonReader& reader;
+
+			template <typename TEnum>
+			bool ReadLabel(TEnum& val) {
+				if (reader.Peek() != '"') {
+					int32_t num;
+					if (!reader.Number(num))
+						return false;
+					val = static_cast<TEnum>(num);
+					return true;
+				}
+				std::string_view label;
+				if (!reader.String(label))
+					return false;
+				for (auto& [opVal, opLabel] : enums::GetDict<TEnum>()) {
+					if (label == opLabel) {
+						val = opVal;
+						return true;
+					}
+				}
+				return reader.Error();
+			}
+
+			template <typename T>
+			bool operator()(std::reference_wrapper<T> ref) {
+				T& val = ref.get();
+				if constexpr (std::is_same_v<T, int> || std::is_same_v<T, float>)
+					return reader.Number(val);
+				else if constexpr (isFlagType<T>) {
+					T flags = static_cast<T>(0);
+					reader.BeginArray();
+					while (reader.NextElement()) {
+						T flag;
+						if (!ReadLabel(flag))
+							return false;
+						flags = static_cast<T>(flags | flag);
+					}
+					val = flags;
+					return reader.Ok();
+				}
+				else
+					return ReadLabel(val);
+			}
+		};
+
+		std::shared_ptr<NodeBase> MakeNode(NodeKind kind) {
+			switch (kind) {
+			case NodeKind::AttachmentDescriptionEditor:
+				// placeholder values, overwritten by the members in the file
+				return std::make_shared<ObjectEditorNode<VkAttachmentDescription>>("", static_cast<VkAttachmentDescriptionFlags>(0), VK_FORMAT_UNDEFINED, VK_SAMPLE_COUNT_1_BIT);
+			case NodeKind::YourStructEditor:
+				return std::make_shared<ObjectEditorNode<YourStruct>>("");
+			case NodeKind::Viewer:
+				return std::make_shared<ObjectViewerNode>();
+			case NodeKind::RenderPass:
+				return std::make_shared<RenderPassNode>();
+			default:
+				return nullptr;
+			}
+		}
+	}
+
+	bool SaveGraphJson(const std::string& path, const Graph& graph, const std::function<ImVec2(int nodeId)>& getNodePos) {
+		JsonWriter w;
+		w.out += "{\n\t\"version\": ";
+		w.Number(jsonVersion);
+		w.out += ",\n\t\"nodes\": [";
+		const char* separator = "\n";
+		for (const std::shared_ptr<NodeBase>& ndPtr : graph.nodes) {
+			NodeBase& nd = *ndPtr;
+			w.out += separator;
+			separator = ",\n";
+
+			// kind comes first, so that a reader knows which node to construct before reading its object
+			w.out += "\t\t{ \"kind\": ";
+			w.String(nodeKindNames[static_cast<size_t>(nd.kind)]);
+			w.out += ", \"id\": ";
+			w.Number(nd.id);
+			w.out += ", \"title\": ";
+			w.String(nd.title);
+			const ImVec2 pos = getNodePos(nd.id);
+			w.out += ", \"pos\": [";
+			w.Number(pos.x);
+			w.out += ", ";
+			w.Number(pos.y);
+			w.out += "], \"attributes\": [";
+			const char* attrSeparator = "";
+			for (auto attrRef : nd.GetAllAttributes()) {
+				w.out += attrSeparator;
+				attrSeparator = ", ";
+				w.Number(attrRef.get().id);
+			}
+			w.out += ']';
+
+			if (std::vector<ValueAttribute>* values = GetValueAttributes(nd)) {
+				w.out += ",\n\t\t\t\"object\": {";
+				const char* valueSeparator = " ";
+				for (const ValueAttribute& attr : *values) {
+					w.out += valueSeparator;
+					valueSeparator = ", ";
+					w.String(attr.name);
+					w.out += ": ";
+					std::visit(w, attr.value);
+				}
+				w.out += " }";
+			}
+			w.out += " }";
+		}
+		w.out += "\n\t],\n\t\"links\": [";
+		separator = "\n";
+		for (const Link& link : graph.links) {
+			w.out += separator;
+			separator = ",\n";
+			w.out += "\t\t[";
+			w.Number(link.startAttrId);
+			w.out += ", ";
+			w.Number(link.endAttrId);
+			w.out += ']';
+		}
+		w.out += "\n\t]\n}\n";
+
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+		out.write(w.out.data(), w.out.size());
+		return out.good();
+	}
+
+	bool LoadGraphJson(const std::string& path, Graph& graph, const std::function<void(int nodeId, ImVec2 pos)>& setNodePos) {
+		const MappedFile mapped{ path };
+		if (mapped.data == nullptr)
+			return Fail(path, "cannot map file");
+		const char* text = reinterpret_cast<const char*>(mapped.data);
+		JsonReader reader{ text, text + mapped.size };
+
+		Graph loaded{};
+		std::vector<std::pair<int, ImVec2>> positions;
+		std::vector<int32_t> attributeIds;
+		std::vector<Link> links;
+
+		std::string_view key;
+		reader.BeginObject();
+		while (reader.NextMember(key)) {
+			if (key == "version") {
+				uint32_t version{};
+				if (reader.Number(version) && version != jsonVersion)
+					return Fail(path, "unsupported version");
+			}
+			else if (key == "nodes") {
+				reader.BeginArray();
+				while (reader.NextElement()) {
+					std::shared_ptr<NodeBase> nd;
+					int id{ -1 };
+					std::string title;
+					ImVec2 pos{};
+					attributeIds.clear();
+
+					reader.BeginObject();
+					while (reader.NextMember(key)) {
+						if (key == "kind") {
+							std::string_view name;
+							reader.String(name);
+							for (size_t i = 0; i < std::size(nodeKindNames); ++i)
+								if (name == nodeKindNames[i])
+									nd = MakeNode(static_cast<NodeKind>(i));
+							if (nd == nullptr)
+								return Fail(path, "unknown node kind");
+						}
+						else if (key == "id")
+							reader.Number(id);
+						else if (key == "title") {
+							std::string_view str;
+							if (reader.String(str))
+								title = str;
+						}
+						else if (key == "pos") {
+							int count{};
+							reader.BeginArray();
+							while (reader.NextElement()) {
+								if (count < 2)
+									reader.Number(count == 0 ? pos.x : pos.y);
+								else
+									reader.Skip();
+								++count;
+							}
+							if (reader.Ok() && count != 2)
+								return Fail(path, "pos should have two numbers");
+						}
+						else if (key == "attributes") {
+							reader.BeginArray();
+							while (reader.NextElement()) {
+								int32_t attrId{ -1 };
+								reader.Number(attrId);
+								attributeIds.push_back(attrId);
+							}
+						}
+						else if (key == "object") {
+							std::vector<ValueAttribute>* values = nd ? GetValueAttributes(*nd) : nullptr;
+							if (values == nullptr)
+								return Fail(path, "object before kind, or in a node without one");
+							reader.BeginObject();
+							while (reader.NextMember(key)) {
+								// members are matched by attribute name, unknown ones are skipped
+								auto it = std::find_if(values->begin(), values->end(), [&](const ValueAttribute& attr) { return attr.name == key; });
+								if (it != values->end())
+									std::visit(JsonValueReader{ reader }, it->value);
+								else
+									reader.Skip();
+							}
+						}
+						else
+							reader.Skip();
+					}
+					if (!reader.Ok())
+						break;
+
+					if (nd == nullptr)
+						return Fail(path, "node without kind");
+					if (HasUnlabeledValue(*nd))
+						return Fail(path, "enum value without a label");
+					if (!loaded.nodes.is_free(id))
+						return Fail(path, "invalid node id");
+					nd->id = id;
+					nd->title = std::move(title);
+					if (const char* error = SetAttributeIds(loaded, *nd, attributeIds.data(), attributeIds.size()))
+						return Fail(path, error);
+					loaded.AddNode(nd);
+					positions.emplace_back(id, pos);
+				}
+			}
+			else if (key == "links") {
+				reader.BeginArray();
+				while (reader.NextElement()) {
+					Link& link = links.emplace_back(Link{ -1, -1, -1 });
+					int count{};
+					reader.BeginArray();
+					while (reader.NextElement()) {
+						if (count < 2)
+							reader.Number(count == 0 ? link.startAttrId : link.endAttrId);
+						else
+							reader.Skip();
+						++count;
+					}
+					if (reader.Ok() && count != 2)
+						return Fail(path, "link should have two attribute ids");
+				}
+			}
+			else
+				reader.Skip();
+		}
+		if (!reader.Ok() || !reader.AtEnd())
+			return Fail(path, "syntax error");
+
+		// links after all nodes, since they may come first in a hand edited file
+		for (const Link& link : links) {
+			if (!loaded.attributes.contains(link.startAttrId) || !loaded.attributes.contains(link.endAttrId))
+				return Fail(path, "link refers to a missing attribute");
+			if (loaded.AddLink(link.startAttrId, link.endAttrId) == -1)
+				return Fail(path, "link between attributes that cannot be linked");
+		}
+
+		graph = std::move(loaded);
+		for (const auto& [nodeId, pos] : positions)
+			setNodePos(nodeId, pos);
+		return true;
+	}
+}
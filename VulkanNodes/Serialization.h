@@ -0,0 +1,73 @@
+#pragma once
+
+#include "NodeEditor.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ne {
+	// Binary graph file. Sections are arrays of fixed-size records so that a memory-mapped file can be read in place.
+	// Layout: Header | NodeRecord[numNodes] | int32 attributeIds[numAttributes] | LinkRecord[numLinks] | char strings[stringsSize]
+	// Values are stored in the byte order of the machine that saved the file.
+	namespace file {
+		constexpr char magic[4]{ 'V', 'N', 'G', 'R' };
+		// Increment when the layout of any record changes
+		constexpr uint32_t version{ 1 };
+
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint32_t numNodes;
+			uint32_t numAttributes;
+			uint32_t numLinks;
+			uint32_t stringsSize;
+		};
+
+		// Large enough for the object of any editor node
+		constexpr size_t objectSize{ std::max(sizeof(VkAttachmentDescription), sizeof(YourStruct)) };
+
+		struct NodeRecord {
+			int32_t id;
+			NodeKind kind;
+			uint8_t padding[3];
+			float posX;
+			float posY;
+			// title in the string table
+			uint32_t titleOffset;
+			uint32_t titleSize;
+			// ids of attributes, in the order of NodeBase::GetAllAttributes()
+			uint32_t firstAttribute;
+			uint32_t numAttributes;
+			// object of an editor node, as is
+			alignas(4) uint8_t object[objectSize];
+		};
+
+		struct LinkRecord {
+			int32_t startAttrId;
+			int32_t endAttrId;
+		};
+	}
+
+	// Text graph file in JSON, meant to be diffed and merged under version control. Holds the same data as the binary file.
+	// Object members are written by attribute name, enums and flags with their labels in ne::enums.
+	// { "version": 1,
+	//   "nodes": [ { "kind": "YourStructEditor", "id": 1, "title": "Node2", "pos": [0, 0], "attributes": [2, 3, 4, 5],
+	//                "object": { "num": 4, "magnitude": 3.14, "color components": ["R", "G"] } }, ... ],
+	//   "links": [ [5, 9], ... ] }
+	constexpr uint32_t jsonVersion{ 1 };
+
+	// Writes nodes, their objects, links and node positions given by getNodePos. Returns false if file cannot be written.
+	bool SaveGraph(const std::string& path, const Graph& graph, const std::function<ImVec2(int nodeId)>& getNodePos);
+	// Replaces graph with the one in the file and reports saved node positions via setNodePos.
+	// Returns false and leaves graph untouched if the file cannot be read or is not a valid graph file.
+	bool LoadGraph(const std::string& path, Graph& graph, const std::function<void(int nodeId, ImVec2 pos)>& setNodePos);
+
+	// Same as SaveGraph and LoadGraph, in the JSON format. Loading streams through the text without building a document tree.
+	// Within a node, "kind" has to come before "object".
+	bool SaveGraphJson(const std::string& path, const Graph& graph, const std::function<ImVec2(int nodeId)>& getNodePos);
+	bool LoadGraphJson(const std::string& path, Graph& graph, const std::function<void(int nodeId, ImVec2 pos)>& setNodePos);
+}
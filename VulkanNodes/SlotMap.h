@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ne {
+	// Keeps values in a contiguous array for fast iteration and addresses them via stable ids.
+	// An id is an int, so that it can be handed to ImNodes as is. Its low bits select a slot and its high bits hold
+	// the generation of that slot, which is bumped at every erase, so that ids of erased values don't alias new ones.
+	// A slot whose generation would wrap around is retired instead, i.e. never reused, so that ids never repeat.
+	// Erasing moves the last value into the hole, hence iteration order is not insertion order.
+	template <typename T>
+	class SlotMap {
+	public:
+		using Id = int;
+
+		static constexpr int indexBits{ 22 };
+		static constexpr uint32_t indexMask{ (1u << indexBits) - 1 };
+		static constexpr uint32_t generationMask{ (1u << (31 - indexBits)) - 1 };
+
+		static constexpr uint32_t IndexOf(Id id) { return static_cast<uint32_t>(id) & indexMask; }
+		static constexpr uint32_t GenerationOf(Id id) { return static_cast<uint32_t>(id) >> indexBits; }
+		static constexpr Id MakeId(uint32_t index, uint32_t generation) { return static_cast<Id>((generation << indexBits) | index); }
+
+		Id insert(T value) {
+			// skip slots that were taken by insert_at, or retired
+			while (!freeSlots.empty() && (slots[freeSlots.back()].denseIx != freeSlot || slots[freeSlots.back()].generation == retiredGeneration))
+				freeSlots.pop_back();
+
+			uint32_t slotIx;
+			if (freeSlots.empty()) {
+				slotIx = static_cast<uint32_t>(slots.size());
+				assert(slotIx <= indexMask); // out of slots
+				slots.push_back({});
+			}
+			else {
+				slotIx = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			return Occupy(slotIx, std::move(value));
+		}
+
+		// Insert under an id that was handed out before, e.g. when loading a saved graph. The slot of the id must be free,
+		// and must not have handed out a later generation. The slot stays in freeSlots and is skipped by insert,
+		// so that inserting many ids in any order is linear.
+		void insert_at(Id id, T value) {
+			assert(is_free(id)); // slot of id is in use, or is past the generation of id
+			const uint32_t slotIx{ IndexOf(id) };
+			if (slotIx >= slots.size()) {
+				for (uint32_t ix = static_cast<uint32_t>(slots.size()); ix < slotIx; ++ix)
+					freeSlots.push_back(ix);
+				slots.resize(slotIx + 1);
+			}
+			// never lowered, so that ids handed out later can't equal earlier ones
+			slots[slotIx].generation = std::max(slots[slotIx].generation, GenerationOf(id));
+			Occupy(slotIx, std::move(value));
+		}
+
+		// Whether insert_at can be called with id
+		bool is_free(Id id) const {
+			if (id < 0)
+				return false;
+			const uint32_t slotIx{ IndexOf(id) };
+			return slotIx >= slots.size() || (slots[slotIx].denseIx == freeSlot && GenerationOf(id) >= slots[slotIx].generation);
+		}
+
+		void erase(Id id) {
+			assert(contains(id));
+			const uint32_t slotIx{ IndexOf(id) };
+			const uint32_t denseIx{ slots[slotIx].denseIx };
+
+			// fill the hole with the last value
+			const uint32_t lastIx{ static_cast<uint32_t>(values.size() - 1) };
+			if (denseIx != lastIx) {
+				values[denseIx] = std::move(values[lastIx]);
+				denseIds[denseIx] = denseIds[lastIx];
+				slots[IndexOf(denseIds[denseIx])].denseIx = denseIx;
+			}
+			values.pop_back();
+			denseIds.pop_back();
+
+			slots[slotIx].denseIx = freeSlot;
+			// a retired slot may still be in freeSlots, after insert_at, and is skipped by insert
+			if (++slots[slotIx].generation != retiredGeneration)
+				freeSlots.push_back(slotIx);
+		}
+
+		bool contains(Id id) const {
+			if (id < 0)
+				return false;
+			const uint32_t slotIx{ IndexOf(id) };
+			return slotIx < slots.size() && slots[slotIx].denseIx != freeSlot && slots[slotIx].generation == GenerationOf(id);
+		}
+
+		T& at(Id id) {
+			assert(contains(id));
+			return values[slots[IndexOf(id)].denseIx];
+		}
+
+		const T& at(Id id) const {
+			assert(contains(id));
+			return values[slots[IndexOf(id)].denseIx];
+		}
+
+		T* find(Id id) {
+			return contains(id) ? &values[slots[IndexOf(id)].denseIx] : nullptr;
+		}
+
+		const T* find(Id id) const {
+			return contains(id) ? &values[slots[IndexOf(id)].denseIx] : nullptr;
+		}
+
+		void reserve(size_t count) {
+			values.reserve(count);
+			denseIds.reserve(count);
+			slots.reserve(count);
+		}
+
+		void clear() {
+			values.clear();
+			denseIds.clear();
+			slots.clear();
+			freeSlots.clear();
+		}
+
+		size_t size() const { return values.size(); }
+		bool empty() const { return values.empty(); }
+
+		// Ids of the values, in iteration order
+		const std::vector<Id>& ids() const { return denseIds; }
+
+		auto begin() { return values.begin(); }
+		auto end() { return values.end(); }
+		auto begin() const { return values.begin(); }
+		auto end() const { return values.end(); }
+
+	private:
+		static constexpr uint32_t freeSlot{ UINT32_MAX };
+		// generation of a slot which handed out all generations, no id has it
+		static constexpr uint32_t retiredGeneration{ generationMask + 1 };
+
+		struct Slot {
+			uint32_t denseIx{ freeSlot };
+			uint32_t generation{};
+		};
+
+		std::vector<T> values;
+		std::vector<Id> denseIds;
+		std::vector<Slot> slots;
+		std::vector<uint32_t> freeSlots;
+
+		Id Occupy(uint32_t slotIx, T&& value) {
+			const Id id{ MakeId(slotIx, slots[slotIx].generation) };
+			slots[slotIx].denseIx = static_cast<uint32_t>(values.size());
+			values.push_back(std::move(value));
+			denseIds.push_back(id);
+			return id;
+		}
+	};
+}
@@ -0,0 +1,100 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+namespace {
+	// Worker that runs on this thread, so that a task submitted by a task goes to the queue of its worker
+	thread_local const TaskScheduler* currentScheduler{ nullptr };
+	thread_local size_t currentWorkerIx{ 0 };
+}
+
+TaskScheduler::TaskScheduler(size_t numWorkers) {
+	for (size_t i = 0; i < numWorkers + 1; ++i)
+		queues.push_back(std::make_unique<Queue>());
+	for (size_t i = 0; i < numWorkers; ++i)
+		workers.emplace_back(&TaskScheduler::WorkerLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler() {
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+size_t TaskScheduler::DefaultNumWorkers() {
+	const size_t numThreads = std::thread::hardware_concurrency();
+	return std::max(numThreads, size_t{ 1 }) - 1;
+}
+
+void TaskScheduler::Submit(TaskGroup& group, std::function<void()> task) {
+	group.numPending.fetch_add(1, std::memory_order_relaxed);
+	Queue& queue = *queues[OwnQueueIx()];
+	{
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		queue.tasks.push_back({ std::move(task), &group });
+	}
+	numQueued.fetch_add(1);
+	// Taking the lock orders this after the check of a worker that is about to sleep, so that the wake up is not lost
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+	}
+	wakeUp.notify_one();
+}
+
+void TaskScheduler::Wait(TaskGroup& group) {
+	const size_t ownQueueIx = OwnQueueIx();
+	while (group.numPending.load(std::memory_order_acquire) > 0)
+		if (!TryRunOne(ownQueueIx))
+			std::this_thread::yield();
+}
+
+size_t TaskScheduler::OwnQueueIx() const {
+	return currentScheduler == this ? currentWorkerIx : queues.size() - 1;
+}
+
+bool TaskScheduler::TryRunOne(size_t ownQueueIx) {
+	Task task{};
+	bool found{ false };
+	{
+		Queue& own = *queues[ownQueueIx];
+		std::lock_guard<std::mutex> lock{ own.mutex };
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			found = true;
+		}
+	}
+	for (size_t i = 1; !found && i < queues.size(); ++i) {
+		Queue& victim = *queues[(ownQueueIx + i) % queues.size()];
+		std::lock_guard<std::mutex> lock{ victim.mutex };
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+
+	numQueued.fetch_sub(1);
+	task.func();
+	task.group->numPending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void TaskScheduler::WorkerLoop(size_t workerIx) {
+	currentScheduler = this;
+	currentWorkerIx = workerIx;
+	while (true) {
+		if (TryRunOne(workerIx))
+			continue;
+		std::unique_lock<std::mutex> lock{ sleepMutex };
+		wakeUp.wait(lock, [this] { return stopping || numQueued.load() > 0; });
+		if (stopping && numQueued.load() == 0)
+			return;
+	}
+}
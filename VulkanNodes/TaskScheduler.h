@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs tasks on a fixed set of worker threads. Each worker has its own queue: it runs its newest task first, and when its queue
+// is empty it steals the oldest task of another queue. Tasks submitted by a task go to the queue of its worker, so that
+// a chain of dependent tasks stays on one thread, and other workers only take over when they run out of work.
+class TaskScheduler {
+public:
+	// Counts unfinished tasks, so that they can be waited on
+	struct TaskGroup {
+		std::atomic<size_t> numPending{ 0 };
+	};
+
+	// With 0 workers, tasks are only run by threads that Wait
+	TaskScheduler(size_t numWorkers = DefaultNumWorkers());
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+	~TaskScheduler();
+
+	// Can be called from tasks, and from any thread
+	void Submit(TaskGroup& group, std::function<void()> task);
+	// Runs tasks of any group until all tasks of given group are finished, so that the waiting thread contributes instead of blocking
+	void Wait(TaskGroup& group);
+
+	size_t GetNumWorkers() const { return workers.size(); }
+	// One worker per hardware thread, except the one that waits
+	static size_t DefaultNumWorkers();
+private:
+	struct Task {
+		std::function<void()> func;
+		TaskGroup* group;
+	};
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+	// one per worker, and a last one for tasks submitted by other threads
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	// tasks in all queues, workers sleep when it is 0
+	std::atomic<size_t> numQueued{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopping{ false };
+
+	// Queue of calling thread
+	size_t OwnQueueIx() const;
+	// Runs a task from own queue, or stolen from another. Returns false if all queues were empty.
+	bool TryRunOne(size_t ownQueueIx);
+	void WorkerLoop(size_t workerIx);
+};
@@ -1,6 +1,10 @@
 #include "VulkanContext.h"
+#include "Profiler.h"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 
@@ -27,39 +31,130 @@ static uint32_t GetMemoryType(VkPhysicalDeviceMemoryProperties memoryProperties,
 }
 
 VulkanContext::VulkanContext(const Window& win)
+	: VulkanContext(&win, {}) {}
+
+VulkanContext::VulkanContext(VkExtent2D offscreenExtent)
+	: VulkanContext(nullptr, offscreenExtent) {}
+
+VulkanContext::VulkanContext(const Window* win, VkExtent2D offscreenExtent)
 	: win(win),
+	offscreenExtent(offscreenExtent),
 	instance(InitInstance()),
 	surface(InitSurface()),
 	device(InitDevice()),
 	graphics_queue(vkb::detail::GetResult(device.get_queue(vkb::QueueType::graphics))),
-	present_queue(vkb::detail::GetResult(device.get_queue(vkb::QueueType::present))),
-	swapchain(vkb::detail::GetResult(vkb::SwapchainBuilder(device).build())),
-	// vkb::Swapchain's get_images() and _views methods are meant to be only called once after Swapchain is created
-	// It's a confusing API, so we have to make sure to update swapchainData any time we recreate swapchain too
-	swapchainData({ swapchain.get_images().value(), swapchain.get_image_views().value() }),
+	// there is nothing to present when offscreen
+	present_queue(IsOffscreen() ? graphics_queue : vkb::detail::GetResult(device.get_queue(vkb::QueueType::present))),
+	pipelineCache(CreatePipelineCache()),
+	swapchain(IsOffscreen() ? vkb::Swapchain{} : vkb::detail::GetResult(vkb::SwapchainBuilder(device).build())),
+	offscreenColorAttachment(CreateOffscreenColorAttachment()),
+	swapchainData(InitSwapchainData()),
     surfaceDepthFormat(VK_FORMAT_D24_UNORM_S8_UINT),
 	surfaceRenderPass(CreateSurfaceRenderPass()),
 	surfaceDepthAttachment(CreateDepthAttachment()),
 	surfaceFramebuffers(CreateFramebuffers()),
 	commandPool(CreateCommandPool()),
-	commandBuffer(CreateCommandBuffer()),
-	sync(InitSync()) {}
+	commandBuffers(CreateCommandBuffers()),
+	readbackBuffer(CreateReadbackBuffer()),
+	sync(InitSync()),
+	timestampQueryPool(CreateTimestampQueryPool()) {}
 
 vkb::Instance VulkanContext::InitInstance() {
 	vkb::InstanceBuilder instanceBuilder = vkb::InstanceBuilder()
-		.use_default_debug_messenger()
-		.enable_validation_layers();
-	for (const auto& extName : win.GetInstanceExtensions())
-		instanceBuilder.enable_extension(extName);
+		.use_default_debug_messenger();
+	if (IsOffscreen()) {
+		// no surface extensions. Software drivers in containers usually come without validation layers.
+		instanceBuilder.set_headless(true);
+		instanceBuilder.request_validation_layers();
+	}
+	else {
+		instanceBuilder.enable_validation_layers();
+		for (const auto& extName : win->GetInstanceExtensions())
+			instanceBuilder.enable_extension(extName);
+	}
 	return vkb::detail::GetResult(instanceBuilder.build());
 }
 
 VkSurfaceKHR VulkanContext::InitSurface() {
+	if (IsOffscreen())
+		return VK_NULL_HANDLE;
 	VkSurfaceKHR surface;
-	win.CreateSurface(instance, &surface);
+	win->CreateSurface(instance, &surface);
 	return surface;
 }
 
+VulkanContext::SwapchainData VulkanContext::InitSwapchainData() {
+	if (IsOffscreen())
+		return { { offscreenColorAttachment.image }, { offscreenColorAttachment.imageView } };
+	// vkb::Swapchain's get_images() and _views methods are meant to be only called once after Swapchain is created
+	// It's a confusing API, so we have to make sure to update swapchainData any time we recreate swapchain too
+	return { swapchain.get_images().value(), swapchain.get_image_views().value() };
+}
+
+// Cache data of another device or driver is ignored by drivers anyway, but some crash on it. Hence check it before use.
+static bool IsPipelineCacheCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties) {
+	VkPipelineCacheHeaderVersionOne header;
+	if (data.size() < sizeof(header))
+		return false;
+	std::memcpy(&header, data.data(), sizeof(header));
+	return header.headerSize >= sizeof(header) && header.headerSize <= data.size()
+		&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header.vendorID == properties.vendorID
+		&& header.deviceID == properties.deviceID
+		&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkPipelineCache VulkanContext::CreatePipelineCache() {
+	std::vector<char> data;
+	std::ifstream file(pipelineCacheFile, std::ios::ate | std::ios::binary);
+	if (file.is_open()) {
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file || !IsPipelineCacheCompatible(data, device.physical_device.properties)) {
+			std::cout << "Ignoring incompatible pipeline cache " << pipelineCacheFile << "\n";
+			data.clear();
+		}
+	}
+	pipelineCacheLoaded = !data.empty();
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize = data.size();
+	info.pInitialData = data.data();
+
+	VkPipelineCache cache;
+	if (vkCreatePipelineCache(device, &info, nullptr, &cache) != VK_SUCCESS) {
+		std::cout << "failed to create pipeline cache\n";
+		exit(EXIT_FAILURE);
+	}
+	return cache;
+}
+
+void VulkanContext::SavePipelineCache() {
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS)
+		return;
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+		return;
+
+	// Written next to the cache and renamed, so that a crash while writing doesn't leave a truncated cache behind
+	const std::string tmpFile = std::string{ pipelineCacheFile } + ".tmp";
+	{
+		std::ofstream file(tmpFile, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(size));
+		if (!file) {
+			std::cout << "Cannot write pipeline cache " << tmpFile << "\n";
+			return;
+		}
+	}
+	std::error_code err;
+	std::filesystem::rename(tmpFile, pipelineCacheFile, err);
+	if (err)
+		std::cout << "Cannot write pipeline cache " << pipelineCacheFile << ": " << err.message() << "\n";
+}
+
 VkCommandPool VulkanContext::CreateCommandPool() {
 	VkCommandPoolCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -75,35 +170,31 @@ VkCommandPool VulkanContext::CreateCommandPool() {
 }
 
 vkb::Device VulkanContext::InitDevice() {
-	vkb::PhysicalDevice physical_device = vkb::detail::GetResult(
-		vkb::PhysicalDeviceSelector(instance).set_surface(surface).select()
-	);
+	vkb::PhysicalDeviceSelector selector(instance);
+	if (!IsOffscreen())
+		selector.set_surface(surface);
+	vkb::PhysicalDevice physical_device = vkb::detail::GetResult(selector.select());
 	return vkb::detail::GetResult(vkb::DeviceBuilder(physical_device).build());
 }
 
-VkCommandBuffer VulkanContext::CreateCommandBuffer() {
-	VkCommandBuffer cmdBuf;
+std::vector<VkCommandBuffer> VulkanContext::CreateCommandBuffers() {
+	std::vector<VkCommandBuffer> cmdBufs(MAX_FRAMES_IN_FLIGHT);
 	VkCommandBufferAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = commandPool;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = 1u;
+	allocInfo.commandBufferCount = static_cast<uint32_t>(cmdBufs.size());
 
-	if (vkAllocateCommandBuffers(device, &allocInfo, &cmdBuf) != VK_SUCCESS) {
+	if (vkAllocateCommandBuffers(device, &allocInfo, cmdBufs.data()) != VK_SUCCESS) {
 		exit(EXIT_FAILURE);
 	}
 
-	return cmdBuf;
+	return cmdBufs;
 }
 
 std::vector<VkFramebuffer> VulkanContext::CreateFramebuffers() {
+	// Depth attachment is owned by the constructor and RecreateSwapchain, since frames in flight can still be using the current one
 	std::vector<VkFramebuffer> framebuffers;
-
-	vkDestroyImage(device, surfaceDepthAttachment.image, nullptr);
-	vkDestroyImageView(device, surfaceDepthAttachment.imageView, nullptr);
-	vkFreeMemory(device, surfaceDepthAttachment.memory, nullptr);
-
-	surfaceDepthAttachment = CreateDepthAttachment();
 	framebuffers.resize(swapchainData.imageViews.size());
 
 	for (size_t i = 0; i < swapchainData.imageViews.size(); i++) {
@@ -114,8 +205,8 @@ std::vector<VkFramebuffer> VulkanContext::CreateFramebuffers() {
 		framebuffer_info.renderPass = surfaceRenderPass;
 		framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
 		framebuffer_info.pAttachments = attachments.data();
-		framebuffer_info.width = swapchain.extent.width;
-		framebuffer_info.height = swapchain.extent.height;
+		framebuffer_info.width = GetExtent().width;
+		framebuffer_info.height = GetExtent().height;
 		framebuffer_info.layers = 1;
 
 		if (vkCreateFramebuffer(device, &framebuffer_info, nullptr, &framebuffers[i]) != VK_SUCCESS) {
@@ -128,14 +219,15 @@ std::vector<VkFramebuffer> VulkanContext::CreateFramebuffers() {
 
 VkRenderPass VulkanContext::CreateSurfaceRenderPass() {
     VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapchain.image_format;
+    colorAttachment.format = GetColorFormat();
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // offscreen image is copied to readbackBuffer after the pass
+    colorAttachment.finalLayout = IsOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -161,6 +253,16 @@ VkRenderPass VulkanContext::CreateSurfaceRenderPass() {
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
+    // Frames in flight share the depth image, and a swapchain image is only available once its semaphore is signaled.
+    // Hence attachment writes of a frame wait for the ones of the previous frame, and layout transitions for acquisition.
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
     std::vector<VkAttachmentDescription> attachments = { colorAttachment, depthAttachment };
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -168,6 +270,8 @@ VkRenderPass VulkanContext::CreateSurfaceRenderPass() {
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
 
     VkRenderPass renderPass;
     VkResult result = vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass);
@@ -183,7 +287,7 @@ VulkanContext::Sync VulkanContext::InitSync() {
 	sync.available_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	sync.finished_semaphore.resize(MAX_FRAMES_IN_FLIGHT);
 	sync.in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
-	sync.image_in_flight.resize(swapchain.image_count, VK_NULL_HANDLE);
+	sync.image_in_flight.resize(swapchainData.images.size(), VK_NULL_HANDLE);
 
 	VkSemaphoreCreateInfo semaphore_info = {};
 	semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -211,7 +315,7 @@ VulkanContext::FramebufferAttachment VulkanContext::CreateDepthAttachment() {
 	depthImageInfo.pNext = nullptr;
 	depthImageInfo.imageType = VK_IMAGE_TYPE_2D;
 	depthImageInfo.format = surfaceDepthFormat;
-	depthImageInfo.extent = { swapchain.extent.width, swapchain.extent.height, 1u };
+	depthImageInfo.extent = { GetExtent().width, GetExtent().height, 1u };
 	depthImageInfo.mipLevels = 1;
 	depthImageInfo.arrayLayers = 1;
 	depthImageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -246,7 +350,136 @@ VulkanContext::FramebufferAttachment VulkanContext::CreateDepthAttachment() {
 	return attachment;
 }
 
+VulkanContext::FramebufferAttachment VulkanContext::CreateOffscreenColorAttachment() {
+	FramebufferAttachment attachment;
+	if (!IsOffscreen())
+		return attachment;
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = offscreenColorFormat;
+	imageInfo.extent = { offscreenExtent.width, offscreenExtent.height, 1u };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+	VkMemoryAllocateInfo memAlloc = {};
+	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	if (vkCreateImage(device, &imageInfo, nullptr, &attachment.image) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+	VkMemoryRequirements memReqs;
+	vkGetImageMemoryRequirements(device, attachment.image, &memReqs);
+	memAlloc.allocationSize = memReqs.size;
+	memAlloc.memoryTypeIndex = GetMemoryType(device.physical_device.memory_properties, memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (vkAllocateMemory(device, &memAlloc, nullptr, &attachment.memory) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+	if (vkBindImageMemory(device, attachment.image, attachment.memory, 0) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+
+	VkImageViewCreateInfo imageViewInfo = {};
+	imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imageViewInfo.image = attachment.image;
+	imageViewInfo.format = offscreenColorFormat;
+	imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageViewInfo.subresourceRange.baseMipLevel = 0;
+	imageViewInfo.subresourceRange.levelCount = 1;
+	imageViewInfo.subresourceRange.baseArrayLayer = 0;
+	imageViewInfo.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(device, &imageViewInfo, nullptr, &attachment.imageView) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+
+	return attachment;
+}
+
+VulkanContext::ReadbackBuffer VulkanContext::CreateReadbackBuffer() {
+	ReadbackBuffer readback;
+	if (!IsOffscreen())
+		return readback;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = VkDeviceSize{ offscreenExtent.width } * offscreenExtent.height * 4;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &readback.buffer) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device, readback.buffer, &memReqs);
+	VkMemoryAllocateInfo memAlloc = {};
+	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memAlloc.allocationSize = memReqs.size;
+	memAlloc.memoryTypeIndex = GetMemoryType(device.physical_device.memory_properties, memReqs.memoryTypeBits,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	if (vkAllocateMemory(device, &memAlloc, nullptr, &readback.memory) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+	if (vkBindBufferMemory(device, readback.buffer, readback.memory, 0) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+	return readback;
+}
+
+void VulkanContext::RecordReadback(VkCommandBuffer cmdBuf) {
+	// color writes of the render pass -> copy. Render pass already transitioned the image to TRANSFER_SRC_OPTIMAL.
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = offscreenColorAttachment.image;
+	imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { offscreenExtent.width, offscreenExtent.height, 1u };
+	vkCmdCopyImageToBuffer(cmdBuf, offscreenColorAttachment.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer, 1, &region);
+
+	// copy -> host reads after the fence
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = readbackBuffer.buffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+		0, nullptr, 1, &bufferBarrier, 0, nullptr);
+}
+
+std::vector<uint8_t> VulkanContext::ReadOffscreenImage() {
+	assert(IsOffscreen());
+	vkWaitForFences(device, static_cast<uint32_t>(sync.in_flight_fences.size()), sync.in_flight_fences.data(), VK_TRUE, UINT64_MAX);
+
+	std::vector<uint8_t> pixels(size_t{ offscreenExtent.width } * offscreenExtent.height * 4);
+	void* mapped;
+	if (vkMapMemory(device, readbackBuffer.memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+		exit(EXIT_FAILURE);
+	}
+	std::memcpy(pixels.data(), mapped, pixels.size());
+	vkUnmapMemory(device, readbackBuffer.memory);
+	return pixels;
+}
+
 VulkanContext::~VulkanContext() {
+	if (timestampQueryPool != VK_NULL_HANDLE)
+		vkDestroyQueryPool(device, timestampQueryPool, nullptr);
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		vkDestroySemaphore(device, sync.finished_semaphore[i], nullptr);
 		vkDestroySemaphore(device, sync.available_semaphores[i], nullptr);
@@ -259,8 +492,21 @@ VulkanContext::~VulkanContext() {
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
 	}
 
-	swapchain.destroy_image_views(swapchainData.imageViews);
-	vkb::destroy_swapchain(swapchain);
+	for (auto& retired : retiredSwapchains) {
+		DestroyRetiredSwapchain(retired);
+	}
+
+	if (IsOffscreen()) {
+		vkDestroyBuffer(device, readbackBuffer.buffer, nullptr);
+		vkFreeMemory(device, readbackBuffer.memory, nullptr);
+		vkDestroyImageView(device, offscreenColorAttachment.imageView, nullptr);
+		vkDestroyImage(device, offscreenColorAttachment.image, nullptr);
+		vkFreeMemory(device, offscreenColorAttachment.memory, nullptr);
+	}
+	else {
+		swapchain.destroy_image_views(swapchainData.imageViews);
+		vkb::destroy_swapchain(swapchain);
+	}
 
 	vkFreeMemory(device, surfaceDepthAttachment.memory, nullptr);
 	vkDestroyImageView(device, surfaceDepthAttachment.imageView, nullptr);
@@ -268,27 +514,62 @@ VulkanContext::~VulkanContext() {
 
 	vkDestroyRenderPass(device, surfaceRenderPass, nullptr);
 
+	SavePipelineCache();
+	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+
 	vkb::destroy_device(device);
-	vkb::destroy_surface(instance, surface);
+	if (!IsOffscreen())
+		vkb::destroy_surface(instance, surface);
 	vkb::destroy_instance(instance);
 }
 
 void VulkanContext::RecreateSwapchain() {
-	vkDeviceWaitIdle(device);
-
-	for (auto& framebuffer : surfaceFramebuffers) {
-		vkDestroyFramebuffer(device, framebuffer, nullptr);
-	}
-	swapchain.destroy_image_views(swapchainData.imageViews);
-
-	auto oldSwapchain = swapchain;
+	// offscreen image has a fixed size
+	if (IsOffscreen())
+		return;
+	// Doesn't wait for the device. Old swapchain is handed to the new one, and is retired together with the objects
+	// built on it. Frames in flight keep rendering into and presenting the old images.
+	RetiredSwapchain retired{ swapchain, swapchainData.imageViews, surfaceFramebuffers, {}, numSubmittedFrames };
 	swapchain = vkb::detail::GetResult(
-		vkb::SwapchainBuilder(device).set_old_swapchain(oldSwapchain).build()
+		vkb::SwapchainBuilder(device).set_old_swapchain(retired.swapchain).build()
 	);
-	vkb::destroy_swapchain(oldSwapchain);
-
 	swapchainData = { swapchain.get_images().value(), swapchain.get_image_views().value() };
+
+	// depth attachment has to match the new extent
+	if (swapchain.extent.width != retired.swapchain.extent.width || swapchain.extent.height != retired.swapchain.extent.height) {
+		retired.depthAttachment = surfaceDepthAttachment;
+		surfaceDepthAttachment = CreateDepthAttachment();
+	}
 	surfaceFramebuffers = CreateFramebuffers();
+	retiredSwapchains.push_back(std::move(retired));
+
+	// new swapchain can have a different number of images, none of which is used by a frame yet
+	sync.image_in_flight.assign(swapchainData.images.size(), VK_NULL_HANDLE);
+	swapchainOutdated = false;
+}
+
+void VulkanContext::DestroyRetiredSwapchain(RetiredSwapchain& retired) {
+	for (auto& framebuffer : retired.framebuffers) {
+		vkDestroyFramebuffer(device, framebuffer, nullptr);
+	}
+	if (retired.depthAttachment.image != VK_NULL_HANDLE) {
+		vkDestroyImageView(device, retired.depthAttachment.imageView, nullptr);
+		vkDestroyImage(device, retired.depthAttachment.image, nullptr);
+		vkFreeMemory(device, retired.depthAttachment.memory, nullptr);
+	}
+	retired.swapchain.destroy_image_views(retired.imageViews);
+	vkb::destroy_swapchain(retired.swapchain);
+}
+
+void VulkanContext::DestroyCompletedRetiredSwapchains() {
+	// Called after waiting for the fence of current frame, i.e. frame numSubmittedFrames - MAX_FRAMES_IN_FLIGHT is complete,
+	// and so are the ones before it. Retired objects were used by frames up to numSubmittedFrames at the time of retirement.
+	std::erase_if(retiredSwapchains, [this](RetiredSwapchain& retired) {
+		if (retired.numSubmittedFrames + MAX_FRAMES_IN_FLIGHT > numSubmittedFrames + 1)
+			return false;
+		DestroyRetiredSwapchain(retired);
+		return true;
+	});
 }
 
 std::vector<char> VulkanContext::ReadFile(const std::string& filename) {
@@ -323,6 +604,10 @@ VkShaderModule VulkanContext::CreateShaderModule(const std::vector<char>& code)
 }
 
 VkPipeline VulkanContext::CreateSurfaceCompatiblePipeline(VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout) {
+	return CreatePipeline(vert, frag, layout, surfaceRenderPass, VK_SAMPLE_COUNT_1_BIT);
+}
+
+VkPipeline VulkanContext::CreatePipeline(VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout, VkRenderPass renderPass, VkSampleCountFlagBits samples) const {
 	VkPipelineShaderStageCreateInfo vert_stage_info = {};
 	vert_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vert_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -350,14 +635,14 @@ VkPipeline VulkanContext::CreateSurfaceCompatiblePipeline(VkShaderModule vert, V
 	VkViewport viewport = {};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
-	viewport.width = (float)swapchain.extent.width;
-	viewport.height = (float)swapchain.extent.height;
+	viewport.width = (float)GetExtent().width;
+	viewport.height = (float)GetExtent().height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
 	VkRect2D scissor = {};
 	scissor.offset = { 0, 0 };
-	scissor.extent = swapchain.extent;
+	scissor.extent = GetExtent();
 
 	VkPipelineViewportStateCreateInfo viewport_state = {};
 	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -379,7 +664,7 @@ VkPipeline VulkanContext::CreateSurfaceCompatiblePipeline(VkShaderModule vert, V
 	VkPipelineMultisampleStateCreateInfo multisampling = {};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.rasterizationSamples = samples;
 
 	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -428,34 +713,52 @@ VkPipeline VulkanContext::CreateSurfaceCompatiblePipeline(VkShaderModule vert, V
 	pipeline_info.pColorBlendState = &color_blending;
 	pipeline_info.pDynamicState = &dynamic_info;
 	pipeline_info.layout = layout;
-	pipeline_info.renderPass = surfaceRenderPass;
+	pipeline_info.renderPass = renderPass;
 	pipeline_info.subpass = 0;
 	pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 
 	VkPipeline graphicsPipeline;
 	assert(vkCreateGraphicsPipelines(
-		device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphicsPipeline) == VK_SUCCESS);
+		device, pipelineCache, 1, &pipeline_info, nullptr, &graphicsPipeline) == VK_SUCCESS);
 	return graphicsPipeline;
 }
 
-void VulkanContext::DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBufFillingFunc) {
-	vkWaitForFences(device, 1, &sync.in_flight_fences[currentInFlightFrame], VK_TRUE, UINT64_MAX);
+void VulkanContext::DrawFrame(const std::function<void(const VkCommandBuffer&)>& cmdBufFillingFunc) {
+	// there is no surface to render into while minimized
+	if (!IsOffscreen() && win->IsMinimized())
+		return;
+	{
+		ProfileScope scope{ "wait for frame in flight" };
+		vkWaitForFences(device, 1, &sync.in_flight_fences[currentInFlightFrame], VK_TRUE, UINT64_MAX);
+	}
+	ReportGpuScopes(currentInFlightFrame);
+	DestroyCompletedRetiredSwapchains();
 
-	uint32_t image_index = 0;
-	VkResult result = vkAcquireNextImageKHR(device,
-		swapchain,
-		UINT64_MAX,
-		sync.available_semaphores[currentInFlightFrame],
-		VK_NULL_HANDLE,
-		&image_index);
-
-	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+	// window was resized since last frame, or presentation reported that swapchain doesn't match the surface anymore
+	if (!IsOffscreen() && (swapchainOutdated || handledResizeCount != win->GetResizeCount())) {
+		handledResizeCount = win->GetResizeCount();
 		RecreateSwapchain();
-		return;
 	}
-	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-		std::cout << "failed to acquire swapchain image. Error " << result << "\n";
-		exit(EXIT_FAILURE);
+
+	// offscreen there is a single image, and nothing to acquire
+	uint32_t image_index = 0;
+	VkResult result = VK_SUCCESS;
+	if (!IsOffscreen()) {
+		result = vkAcquireNextImageKHR(device,
+			swapchain,
+			UINT64_MAX,
+			sync.available_semaphores[currentInFlightFrame],
+			VK_NULL_HANDLE,
+			&image_index);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			swapchainOutdated = true;
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			std::cout << "failed to acquire swapchain image. Error " << result << "\n";
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	if (sync.image_in_flight[image_index] != VK_NULL_HANDLE) {
@@ -465,14 +768,19 @@ void VulkanContext::DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBuf
 
 
 	// Rest cmdBuf, prepare RenderPass Begin, fill draw commands, end renderpass
+	// Fence of this frame is signaled, hence its command buffer is not in use anymore
+	VkCommandBuffer commandBuffer = commandBuffers[currentInFlightFrame];
 	assert(vkResetCommandBuffer(commandBuffer, 0) == VK_SUCCESS);
 
 	VkCommandBufferBeginInfo begin_info = {};
 	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	assert(vkBeginCommandBuffer(commandBuffer, &begin_info) == VK_SUCCESS);
+	// queries have to be reset outside of a render pass
+	if (timestampQueryPool != VK_NULL_HANDLE)
+		vkCmdResetQueryPool(commandBuffer, timestampQueryPool, static_cast<uint32_t>(currentInFlightFrame) * maxGpuScopesPerFrame * 2, maxGpuScopesPerFrame * 2);
 
-	std::vector<VkClearValue> clearValues(2);
+	std::array<VkClearValue, 2> clearValues;
 	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
 	clearValues[1].depthStencil = { 1.0f, 0 };
 
@@ -481,31 +789,37 @@ void VulkanContext::DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBuf
 	render_pass_info.renderPass = surfaceRenderPass;
 	render_pass_info.framebuffer = surfaceFramebuffers[image_index];
 	render_pass_info.renderArea.offset = { 0, 0 };
-	render_pass_info.renderArea.extent = swapchain.extent;
+	render_pass_info.renderArea.extent = GetExtent();
 	render_pass_info.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	render_pass_info.pClearValues = clearValues.data();
 
 	VkViewport viewport = {};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
-	viewport.width = (float)swapchain.extent.width;
-	viewport.height = (float)swapchain.extent.height;
+	viewport.width = (float)GetExtent().width;
+	viewport.height = (float)GetExtent().height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
 	VkRect2D scissor = {};
 	scissor.offset = { 0, 0 };
-	scissor.extent = swapchain.extent;
+	scissor.extent = GetExtent();
 
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
 	vkCmdBeginRenderPass(commandBuffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
 
-	cmdBufFillingFunc(commandBuffer);
+	{
+		ProfileScope scope{ "record commands" };
+		cmdBufFillingFunc(commandBuffer);
+	}
 
 	vkCmdEndRenderPass(commandBuffer);
 
+	if (IsOffscreen())
+		RecordReadback(commandBuffer);
+
 	assert(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS);
 	//
 
@@ -514,19 +828,28 @@ void VulkanContext::DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBuf
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	VkSemaphore wait_semaphores[] = { sync.available_semaphores[currentInFlightFrame] };
 	VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
+	// offscreen frames don't wait for an acquired image and are not presented
+	submitInfo.waitSemaphoreCount = IsOffscreen() ? 0 : 1;
 	submitInfo.pWaitSemaphores = wait_semaphores;
 	submitInfo.pWaitDstStageMask = wait_stages;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 	VkSemaphore signal_semaphores[] = { sync.finished_semaphore[currentInFlightFrame] };
-	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.signalSemaphoreCount = IsOffscreen() ? 0 : 1;
 	submitInfo.pSignalSemaphores = signal_semaphores;
 
 	vkResetFences(device, 1, &sync.in_flight_fences[currentInFlightFrame]);
 
+	gpuScopes[currentInFlightFrame].submitNs = Profiler::Now();
 	assert(vkQueueSubmit(graphics_queue, 1, &submitInfo, sync.in_flight_fences[currentInFlightFrame]) == VK_SUCCESS);
 
+	// frame is submitted, next frame records into the next command buffer while this one executes.
+	// Advanced before presenting, since the objects of this frame are in use even if presentation fails.
+	currentInFlightFrame = (currentInFlightFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	++numSubmittedFrames;
+	if (IsOffscreen())
+		return;
+
 	VkPresentInfoKHR present_info = {};
 	present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -541,13 +864,62 @@ void VulkanContext::DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBuf
 
 	result = vkQueuePresentKHR(present_queue, &present_info);
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-		RecreateSwapchain();
-		return;
+		swapchainOutdated = true;
 	}
 	else if (result != VK_SUCCESS) {
 		std::cout << "failed to present swapchain image\n";
 		exit(EXIT_FAILURE);
 	}
+}
 
-	currentInFlightFrame = (currentInFlightFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+VkQueryPool VulkanContext::CreateTimestampQueryPool() {
+	// graphics queues of a device either all support timestamps or none does
+	if (!device.physical_device.properties.limits.timestampComputeAndGraphics)
+		return VK_NULL_HANDLE;
+
+	VkQueryPoolCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	info.queryCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) * maxGpuScopesPerFrame * 2;
+	VkQueryPool pool;
+	if (vkCreateQueryPool(device, &info, nullptr, &pool) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+	return pool;
+}
+
+void VulkanContext::BeginGpuScope(VkCommandBuffer cmdBuf, const char* name) {
+	GpuScopes& scopes = gpuScopes[currentInFlightFrame];
+	scopes.skipping = timestampQueryPool == VK_NULL_HANDLE || scopes.numScopes == maxGpuScopesPerFrame;
+	if (scopes.skipping)
+		return;
+	scopes.names[scopes.numScopes] = name;
+	const uint32_t query = (static_cast<uint32_t>(currentInFlightFrame) * maxGpuScopesPerFrame + scopes.numScopes) * 2;
+	vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, query);
+}
+
+void VulkanContext::EndGpuScope(VkCommandBuffer cmdBuf) {
+	GpuScopes& scopes = gpuScopes[currentInFlightFrame];
+	if (scopes.skipping)
+		return;
+	const uint32_t query = (static_cast<uint32_t>(currentInFlightFrame) * maxGpuScopesPerFrame + scopes.numScopes) * 2 + 1;
+	vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, query);
+	++scopes.numScopes;
+}
+
+void VulkanContext::ReportGpuScopes(size_t frameIx) {
+	GpuScopes& scopes = gpuScopes[frameIx];
+	if (scopes.numScopes == 0)
+		return;
+
+	std::array<uint64_t, maxGpuScopesPerFrame * 2> timestamps;
+	const VkResult result = vkGetQueryPoolResults(device, timestampQueryPool, static_cast<uint32_t>(frameIx) * maxGpuScopesPerFrame * 2, scopes.numScopes * 2,
+		sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_SUCCESS) {
+		const double nsPerTick = device.physical_device.properties.limits.timestampPeriod;
+		const uint64_t firstTick = *std::min_element(timestamps.begin(), timestamps.begin() + scopes.numScopes * 2);
+		const auto toNs = [&](uint64_t tick) { return scopes.submitNs + static_cast<int64_t>((tick - firstTick) * nsPerTick); };
+		for (uint32_t i = 0; i < scopes.numScopes; ++i)
+			Profiler::Get().AddGpuScope(scopes.names[i], toNs(timestamps[i * 2]), toNs(timestamps[i * 2 + 1]));
+	}
+	scopes.numScopes = 0;
 }
@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.h>
 #include <VkBootstrap.h>
 
+#include <array>
 #include <iostream>
 #include <functional>
 
@@ -25,13 +26,28 @@ namespace vkb {
 class VulkanContext {
 public:
 	VulkanContext(const Window& win);
+	// Renders into an image instead of a window surface, e.g. on a software driver without a display
+	VulkanContext(VkExtent2D offscreenExtent);
 	~VulkanContext();
 
 	void RecreateSwapchain();
 	static std::vector<char> ReadFile(const std::string& filename);
 	VkShaderModule CreateShaderModule(const std::vector<char>& code);
 	VkPipeline CreateSurfaceCompatiblePipeline(VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout);
-	void DrawFrame(std::function<void(const VkCommandBuffer&)> cmdBufFillingFunc);
+	// Pipeline with the same fixed function state as the surface compatible one, for the first subpass of given render pass
+	VkPipeline CreatePipeline(VkShaderModule vert, VkShaderModule frag, VkPipelineLayout layout, VkRenderPass renderPass, VkSampleCountFlagBits samples) const;
+	void DrawFrame(const std::function<void(const VkCommandBuffer&)>& cmdBufFillingFunc);
+	// GPU timestamps around commands of a frame, reported to Profiler once GPU is done with the frame.
+	// Can be used inside a render pass. Scopes are not nested. Ignored if the device has no timestamps.
+	void BeginGpuScope(VkCommandBuffer cmdBuf, const char* name);
+	void EndGpuScope(VkCommandBuffer cmdBuf);
+
+	bool IsOffscreen() const { return win == nullptr; }
+	// Size and format of images rendered into, either swapchain images or the offscreen image
+	VkExtent2D GetExtent() const { return IsOffscreen() ? offscreenExtent : swapchain.extent; }
+	VkFormat GetColorFormat() const { return IsOffscreen() ? offscreenColorFormat : swapchain.image_format; }
+	// Waits for the last frame and returns its pixels in offscreenColorFormat, rows tightly packed
+	std::vector<uint8_t> ReadOffscreenImage();
 public:
 	struct SwapchainData {
 		std::vector<VkImage> images;
@@ -42,6 +58,29 @@ public:
 		VkDeviceMemory memory = VK_NULL_HANDLE;
 		VkImageView imageView = VK_NULL_HANDLE;
 	};
+	struct ReadbackBuffer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+	};
+	// Objects replaced by a swapchain recreation. Frames in flight may still use them, hence they are destroyed once those frames are complete.
+	struct RetiredSwapchain {
+		vkb::Swapchain swapchain;
+		std::vector<VkImageView> imageViews;
+		std::vector<VkFramebuffer> framebuffers;
+		// only set when the extent changed
+		FramebufferAttachment depthAttachment;
+		// frames submitted before retirement
+		uint64_t numSubmittedFrames;
+	};
+	static constexpr uint32_t maxGpuScopesPerFrame = 8;
+	struct GpuScopes {
+		std::array<const char*, maxGpuScopesPerFrame> names{};
+		uint32_t numScopes = 0;
+		// Ticks of GPU clock are mapped to CPU time by placing the first timestamp of a frame at its submission
+		int64_t submitNs = 0;
+		// Begin was called when all scopes were used
+		bool skipping = false;
+	};
 	struct Sync {
 		std::vector<VkSemaphore> available_semaphores;
 		std::vector<VkSemaphore> finished_semaphore;
@@ -49,31 +88,64 @@ public:
 		std::vector<VkFence> image_in_flight;
 	};
 public:
-	const Window& win;
+	// nullptr when offscreen
+	const Window* win;
+	static constexpr VkFormat offscreenColorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	const VkExtent2D offscreenExtent;
 	vkb::Instance instance;
 	VkSurfaceKHR surface = {};
 	vkb::Device device;
 	VkQueue graphics_queue;
 	VkQueue present_queue;
+	// Shared by all pipeline creation, saved to pipelineCacheFile at destruction so that next run creates pipelines faster
+	static constexpr const char* pipelineCacheFile = "pipeline_cache.bin";
+	// whether a compatible cache was found in pipelineCacheFile, i.e. a warm start
+	bool pipelineCacheLoaded = false;
+	VkPipelineCache pipelineCache;
+	// swapchain is not created when offscreen. swapchainData then refers to offscreenColorAttachment.
 	vkb::Swapchain swapchain;
+	FramebufferAttachment offscreenColorAttachment;
 	SwapchainData swapchainData;
 	VkFormat surfaceDepthFormat;
 	VkRenderPass surfaceRenderPass;
 	FramebufferAttachment surfaceDepthAttachment;
 	std::vector<VkFramebuffer> surfaceFramebuffers;
+	// CPU records a frame while GPU executes the previous ones. Each frame in flight has its own command buffer, semaphores and fence.
+	static constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
 	VkCommandPool commandPool;
-	VkCommandBuffer commandBuffer;
-	// TODO: fix the swapchain recreation issue when MAX_FRAMES_IN_FLIGHT > 1
-	const int MAX_FRAMES_IN_FLIGHT = 1;
+	std::vector<VkCommandBuffer> commandBuffers;
+	// offscreen image is copied here at the end of every frame
+	ReadbackBuffer readbackBuffer;
 	Sync sync;
+	// two timestamps per scope, maxGpuScopesPerFrame scopes per frame in flight. VK_NULL_HANDLE if device has no timestamps.
+	VkQueryPool timestampQueryPool;
+	std::array<GpuScopes, MAX_FRAMES_IN_FLIGHT> gpuScopes;
 	size_t currentInFlightFrame = 0;
+	uint64_t numSubmittedFrames = 0;
+	std::vector<RetiredSwapchain> retiredSwapchains;
+	// recreation is done at the beginning of next frame, once for any number of resize events before it
+	uint32_t handledResizeCount = win ? win->GetResizeCount() : 0;
+	bool swapchainOutdated = false;
 private:
+	VulkanContext(const Window* win, VkExtent2D offscreenExtent);
+
 	vkb::Instance InitInstance();
 	VkSurfaceKHR InitSurface();
 	vkb::Device InitDevice();
+	VkPipelineCache CreatePipelineCache();
+	void SavePipelineCache();
 	VkRenderPass CreateSurfaceRenderPass();
 	FramebufferAttachment CreateDepthAttachment();
-	VkCommandBuffer CreateCommandBuffer();
+	FramebufferAttachment CreateOffscreenColorAttachment();
+	SwapchainData InitSwapchainData();
+	std::vector<VkCommandBuffer> CreateCommandBuffers();
+	ReadbackBuffer CreateReadbackBuffer();
+	void RecordReadback(VkCommandBuffer cmdBuf);
+	void DestroyRetiredSwapchain(RetiredSwapchain& retired);
+	void DestroyCompletedRetiredSwapchains();
+	VkQueryPool CreateTimestampQueryPool();
+	// Reads timestamps of a frame whose fence is signaled
+	void ReportGpuScopes(size_t frameIx);
 public:
 	std::vector<VkFramebuffer> CreateFramebuffers();
 	VkCommandPool CreateCommandPool();
@@ -1,20 +1,90 @@
 ﻿#include "VulkanNodes.h"
 #include "NodeEditor.h"
+#include "Headless.h"
 
 #include "Window.h"
 #include "VulkanContext.h"
 #include "ImGuiHelper.h"
+#include "FrameArena.h"
+#include "GraphCompiler.h"
+#include "TaskScheduler.h"
+#include "Profiler.h"
 
 #include <imgui.h>
 #include "dependencies/imnodes.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
 
+// Binary PPM, viewable and diffable by common image tools without any dependency
+static bool WritePpm(const std::string& path, const std::vector<uint8_t>& rgba, VkExtent2D extent) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+	std::vector<char> rgb(size_t{ extent.width } * extent.height * 3);
+	for (size_t px = 0; px < rgb.size() / 3; ++px)
+		for (size_t c = 0; c < 3; ++c)
+			rgb[px * 3 + c] = static_cast<char>(rgba[px * 4 + c]);
+	file.write(rgb.data(), rgb.size());
+	return file.good();
+}
 
-int main() {
-	const Window win{};
+int main(int argc, char* argv[]) {
+	bool headless{ false };
+	HeadlessOptions headlessOptions{};
+	bool offscreen{ false };
+	bool idle{ false };
+	std::string screenshotPath;
+	std::string tracePath;
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue{ i + 1 < argc };
+		if (std::strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (std::strcmp(argv[i], "--load") == 0 && hasValue)
+			headlessOptions.loadPath = argv[++i];
+		else if (std::strcmp(argv[i], "--export") == 0 && hasValue)
+			headlessOptions.exportPath = argv[++i];
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+			headlessOptions.numFrames = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--offscreen") == 0)
+			offscreen = true;
+		else if (std::strcmp(argv[i], "--screenshot") == 0 && hasValue)
+			screenshotPath = argv[++i];
+		else if (std::strcmp(argv[i], "--idle") == 0)
+			idle = true;
+		else if (std::strcmp(argv[i], "--trace") == 0 && hasValue)
+			tracePath = argv[++i];
+		else {
+			std::cerr << "usage: " << argv[0] << " [--headless [--load graph.vng|graph.json] [--export graph.vng|graph.json] [--frames N]]"
+				<< " [--offscreen [--frames N] [--screenshot image.ppm]] [--idle] [--trace trace.json]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	// No window, no Vulkan
+	if (headless)
+		return RunHeadless(headlessOptions);
 
-	VulkanContext vc{ win };
+	// Offscreen renders a fixed number of frames into an image, e.g. on a software driver in a container
+	const int numOffscreenFrames{ std::max(headlessOptions.numFrames, 1) };
+	const auto startupStart = std::chrono::steady_clock::now();
+	std::unique_ptr<const Window> win;
+	std::unique_ptr<VulkanContext> vcPtr;
+	if (offscreen)
+		vcPtr = std::make_unique<VulkanContext>(VkExtent2D{ 1280, 720 });
+	else {
+		win = std::make_unique<const Window>();
+		vcPtr = std::make_unique<VulkanContext>(*win);
+	}
+	VulkanContext& vc{ *vcPtr };
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -25,38 +95,139 @@ int main() {
 	assert(vkCreatePipelineLayout(
 		vc.device, &pipelineLayoutInfo, nullptr, &pipelineLayout) == VK_SUCCESS);
 
+	// Pipelines of the app and ImGui are created from the pipeline cache, which makes them faster in runs after the first one
+	const auto pipelinesStart = std::chrono::steady_clock::now();
 	const auto vertCode{ vc.ReadFile(std::string("shaders/shade-vert.spv")) };
 	const auto fragCode{ vc.ReadFile(std::string("shaders/shade-frag.spv")) };
 	const VkShaderModule vert{ vc.CreateShaderModule(vertCode) };
 	const VkShaderModule frag{ vc.CreateShaderModule(fragCode) };
 	const VkPipeline pipeline{ vc.CreateSurfaceCompatiblePipeline(vert, frag, pipelineLayout) };
-	vkDestroyShaderModule(vc.device, vert, nullptr);
-	vkDestroyShaderModule(vc.device, frag, nullptr);
 
 	const ImGuiHelper imGuiHelper{ vc };
+	const auto startupEnd = std::chrono::steady_clock::now();
+	std::cout << "startup: " << std::chrono::duration<double, std::milli>(startupEnd - startupStart).count() << " ms, pipelines: "
+		<< std::chrono::duration<double, std::milli>(startupEnd - pipelinesStart).count() << " ms with "
+		<< (vc.pipelineCacheLoaded ? "warm" : "cold") << " pipeline cache\n";
 	ne::NodeEditor nodeEditor{ ne::NodeEditor::MakeTestGraph() };
+	// Shader modules are kept alive for pipelines of RenderPass nodes
+	GraphCompiler graphCompiler{ vc, vert, frag, pipelineLayout };
+	// Independent nodes are evaluated concurrently, e.g. pipelines of render passes are compiled in parallel
+	TaskScheduler taskScheduler{};
+
+	// Made once, since a std::function with these captures allocates
+	const std::function<void(const VkCommandBuffer&)> recordCommands =
+		[&](const VkCommandBuffer& cmdBuf) {
+			vc.BeginGpuScope(cmdBuf, "triangle");
+			vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			vkCmdDraw(cmdBuf, 3, 1, 0, 0);
+			vc.EndGpuScope(cmdBuf);
+			vc.BeginGpuScope(cmdBuf, "ImGui");
+			imGuiHelper.AddDrawCalls(cmdBuf);
+			vc.EndGpuScope(cmdBuf);
+		};
 
-	while (!win.ShouldClose()) {
-		win.PollEvents();
+	int exitCode{ EXIT_SUCCESS };
+	Profiler& profiler{ Profiler::Get() };
+	if (!tracePath.empty())
+		profiler.StartTrace();
+	const auto start = std::chrono::steady_clock::now();
+	int numFrames{ 0 };
+	// Should be 0 in steady state, i.e. when nothing is added to the graph or to the UI
+	uint64_t lastFrameHeapAllocations{ 0 };
+	// Idle mode sleeps until there is input, and then draws a few frames so that ImGui settles, e.g. hover state after a click
+	idle = idle && !offscreen;
+	constexpr int numFramesAfterChange{ 3 };
+	int numFramesToDraw{ numFramesAfterChange };
+	uint32_t lastInputCount{ 0 };
+	uint32_t lastResizeCount{ 0 };
+	while (offscreen ? numFrames < numOffscreenFrames : !win->ShouldClose()) {
+		if (idle) {
+			// A frame is drawn at every timeout too, which keeps the text cursor blinking while typing
+			if (numFramesToDraw == 0)
+				win->WaitEvents(ImGui::GetIO().WantTextInput ? 0.5 : 2.0);
+			else
+				win->PollEvents();
+			if (win->GetInputCount() != lastInputCount || win->GetResizeCount() != lastResizeCount) {
+				lastInputCount = win->GetInputCount();
+				lastResizeCount = win->GetResizeCount();
+				numFramesToDraw = numFramesAfterChange;
+			}
+			numFramesToDraw = std::max(numFramesToDraw, 1);
+		}
+		else if (!offscreen)
+			win->PollEvents();
+
+		const uint64_t frameStartHeapAllocations{ GetNumHeapAllocations() };
+		FrameArena& frameArena{ FrameArena::Get() };
+		frameArena.Reset();
+		profiler.BeginFrame();
 
 		imGuiHelper.Begin();
-		nodeEditor.Draw();
+		{
+			ProfileScope scope{ "Graph::Evaluate" };
+			// Only nodes affected by edits of last frame
+			nodeEditor.graph.Evaluate(taskScheduler, [&](ne::NodeBase& nd) {
+				if (nd.kind == ne::NodeKind::RenderPass)
+					graphCompiler.Compile(static_cast<ne::RenderPassNode&>(nd));
+			});
+		}
+		{
+			ProfileScope scope{ "NodeEditor::Draw" };
+			nodeEditor.Draw();
+		}
 
+		ImGui::Begin("Frame");
+		ImGui::Text("heap allocations: %llu", static_cast<unsigned long long>(lastFrameHeapAllocations));
+		ImGui::Text("frame arena: %zu / %zu bytes", frameArena.GetUsedBytes(), frameArena.GetCapacity());
+		ImGui::Text("frames drawn: %d%s", numFrames, idle ? ", idle mode" : "");
+		const GraphCompiler::Stats compilerStats{ graphCompiler.GetStats() };
+		ImGui::Text("render passes: %u created, %u reused, %zu cached", compilerStats.numCreated, compilerStats.numReused, compilerStats.numCached);
+		const ne::Graph::EvaluationStats evaluationStats{ nodeEditor.graph.GetEvaluationStats() };
+		ImGui::Text("evaluations: %u, last one: %zu dirty, %zu evaluated, %zu reused nodes", evaluationStats.numEvaluations,
+			evaluationStats.lastNumDirty, evaluationStats.lastNumEvaluated, evaluationStats.lastNumReused);
+		ImGui::Text("node memo: %zu hits, %zu misses", evaluationStats.totalNumReused, evaluationStats.totalNumEvaluated);
+		ImGui::End();
+
+		profiler.DrawWindow();
 		static bool showDemo{ true };
 		ImGui::ShowDemoWindow(&showDemo);
-		imGuiHelper.End();
+		{
+			ProfileScope scope{ "ImGui::Render" };
+			imGuiHelper.End();
+		}
 
-		vc.DrawFrame(
-			[&](const VkCommandBuffer& cmdBuf) {
-				vkCmdBindPipeline(vc.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-				vkCmdDraw(vc.commandBuffer, 3, 1, 0, 0);
-				imGuiHelper.AddDrawCalls(vc.commandBuffer);
-			});
+		{
+			ProfileScope scope{ "DrawFrame" };
+			vc.DrawFrame(recordCommands);
+		}
+		++numFrames;
+		lastFrameHeapAllocations = GetNumHeapAllocations() - frameStartHeapAllocations;
+		// Edits of this frame are evaluated in the next one
+		if (idle)
+			numFramesToDraw = nodeEditor.graph.HasDirtyNodes() ? numFramesAfterChange : numFramesToDraw - 1;
+	}
+
+	if (offscreen) {
+		vkDeviceWaitIdle(vc.device);
+		const double duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "offscreen frames: " << numFrames << " in " << duration << " ms, " << duration / numFrames << " ms per frame, "
+			<< lastFrameHeapAllocations << " heap allocations in last frame\n";
+		if (!screenshotPath.empty() && !WritePpm(screenshotPath, vc.ReadOffscreenImage(), vc.GetExtent())) {
+			std::cerr << "Cannot write " << screenshotPath << std::endl;
+			exitCode = EXIT_FAILURE;
+		}
+	}
+
+	if (!tracePath.empty() && profiler.IsTracing() && !profiler.SaveTrace(tracePath)) {
+		std::cerr << "Cannot write " << tracePath << std::endl;
+		exitCode = EXIT_FAILURE;
 	}
 
 	// Cleanup
 	vkDeviceWaitIdle(vc.device);
 	vkDestroyPipelineLayout(vc.device, pipelineLayout, nullptr);
 	vkDestroyPipeline(vc.device, pipeline, nullptr);
-	return 0;
+	vkDestroyShaderModule(vc.device, vert, nullptr);
+	vkDestroyShaderModule(vc.device, frag, nullptr);
+	return exitCode;
 }
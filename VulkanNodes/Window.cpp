@@ -19,6 +19,16 @@ GLFWwindow* Window::InitWindow() {
 
 	glfwSetWindowUserPointer(window, this);
 	glfwSetFramebufferSizeCallback(window, OnFramebufferResized);
+	// Installed before ImGui's, which chains to them
+	glfwSetCursorPosCallback(window, [](GLFWwindow* window, double, double) { OnInput(window); });
+	glfwSetMouseButtonCallback(window, [](GLFWwindow* window, int, int, int) { OnInput(window); });
+	glfwSetScrollCallback(window, [](GLFWwindow* window, double, double) { OnInput(window); });
+	glfwSetKeyCallback(window, [](GLFWwindow* window, int, int, int, int) { OnInput(window); });
+	glfwSetCharCallback(window, [](GLFWwindow* window, unsigned int) { OnInput(window); });
+	glfwSetWindowFocusCallback(window, [](GLFWwindow* window, int) { OnInput(window); });
+	glfwSetCursorEnterCallback(window, [](GLFWwindow* window, int) { OnInput(window); });
+	// e.g. window was uncovered, its contents has to be presented again
+	glfwSetWindowRefreshCallback(window, [](GLFWwindow* window) { OnInput(window); });
 	return window;
 }
 
@@ -42,6 +52,15 @@ void Window::OnFramebufferResized(GLFWwindow* window, int width, int height) {
 	Window* win = static_cast<Window*>(ptr);
 	win->width = width;
 	win->height = height;
+	++win->resizeCount;
+}
+
+void Window::OnInput(GLFWwindow* window) {
+	void* ptr = glfwGetWindowUserPointer(window);
+	if (ptr == nullptr) {
+		return;
+	}
+	++static_cast<Window*>(ptr)->inputCount;
 }
 
 VkResult Window::CreateSurface(VkInstance instance, VkSurfaceKHR* surface) const {
@@ -55,3 +74,7 @@ bool Window::ShouldClose() const {
 void Window::PollEvents() const {
 	glfwPollEvents();
 }
+
+void Window::WaitEvents(double timeoutSeconds) const {
+	glfwWaitEventsTimeout(timeoutSeconds);
+}
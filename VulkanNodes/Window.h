@@ -18,21 +18,31 @@ public:
 
 	bool ShouldClose() const;
 	void PollEvents() const;
+	// Sleeps until an event arrives or timeout elapses, then processes events like PollEvents
+	void WaitEvents(double timeoutSeconds) const;
 
 	// Getters
 	GLFWwindow* GetGLFWWindow() const { return window; }
 	const std::vector<const char*>& GetInstanceExtensions() const { return extensions; }
 	const int GetWidth() const { return width; }
 	const int GetHeight() const { return height; }
+	// Incremented by every framebuffer resize event. Renderer compares it once per frame, so that a burst of events causes a single swapchain recreation.
+	uint32_t GetResizeCount() const { return resizeCount; }
+	bool IsMinimized() const { return width == 0 || height == 0; }
+	// Incremented by every mouse, keyboard, focus and refresh event, so that an idle loop knows when to draw again
+	uint32_t GetInputCount() const { return inputCount; }
 private:
 	// construction
 	GLFWwindow* InitWindow();
 	std::vector<const char*> InitExtensions();
 
 	static void OnFramebufferResized(GLFWwindow* window, int width, int height);
+	static void OnInput(GLFWwindow* window);
 private:
 	int width;
 	int height;
+	uint32_t resizeCount{ 0 };
+	uint32_t inputCount{ 0 };
 	GLFWwindow* window;
 	std::vector<const char*> extensions;
 };
\ No newline at end of file
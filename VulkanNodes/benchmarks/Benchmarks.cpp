@@ -0,0 +1,512 @@
+// Benchmarks of graph operations, serialization, evaluation and editor frames, without a window or a GPU.
+// Results are printed as a table, and written as JSON with --json, so that they can be compared across commits.
+#include "NodeEditor.h"
+#include "Serialization.h"
+#include "FrameArena.h"
+#include "TaskScheduler.h"
+#include "Hash.h"
+
+#include <imgui.h>
+#include "dependencies/imnodes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+	struct Options {
+		// editors of VkAttachmentDescription
+		int numEditors{ 10000 };
+		// consumers linked to each editor
+		int fanout{ 1 };
+		// consumers are RenderPass nodes, fed by two editors each, instead of Viewers
+		bool renderPasses{ false };
+		int repeats{ 5 };
+		int numFrames{ 100 };
+		// only benchmarks whose name contains it
+		std::string filter;
+		std::string jsonPath;
+	};
+
+	struct Result {
+		std::string name;
+		size_t numItems;
+		double minMs;
+		double medianMs;
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	class Runner {
+	public:
+		Runner(const Options& options) : options{ options } {}
+
+		bool IsSelected(const std::string& name) const {
+			return options.filter.empty() || name.find(options.filter) != std::string::npos;
+		}
+
+		// run sets up its own state, and returns the milliseconds of the measured part
+		template <typename TRun>
+		void Measure(const std::string& name, size_t numItems, TRun&& run) {
+			if (!IsSelected(name))
+				return;
+			std::vector<double> durations;
+			for (int i = 0; i < options.repeats; ++i)
+				durations.push_back(run());
+			std::sort(durations.begin(), durations.end());
+			const Result result{ name, numItems, durations.front(), durations[durations.size() / 2] };
+			std::printf("%-36s %10zu items %12.3f ms median %12.3f ms min %14.0f items/s\n", name.c_str(), result.numItems,
+				result.medianMs, result.minMs, result.numItems / (result.medianMs * 1e-3));
+			results.push_back(result);
+		}
+
+		// Checks are not part of the timed results. A failed check makes the process fail.
+		void Check(const std::string& name, bool passed) {
+			if (!IsSelected(name))
+				return;
+			std::printf("%-36s %s\n", name.c_str(), passed ? "passed" : "FAILED");
+			allPassed = allPassed && passed;
+		}
+
+		bool WriteJson(const std::string& path) const {
+			std::ofstream file(path);
+			file << "{\"config\":{\"editors\":" << options.numEditors << ",\"fanout\":" << options.fanout
+				<< ",\"consumers\":\"" << (options.renderPasses ? "RenderPass" : "Viewer") << "\",\"repeats\":" << options.repeats
+				<< ",\"frames\":" << options.numFrames << "},\n\"results\":[";
+			for (size_t i = 0; i < results.size(); ++i) {
+				const Result& result = results[i];
+				file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << result.name << "\",\"items\":" << result.numItems
+					<< ",\"median_ms\":" << result.medianMs << ",\"min_ms\":" << result.minMs
+					<< ",\"items_per_second\":" << result.numItems / (result.medianMs * 1e-3) << "}";
+			}
+			file << "\n],\"checks_passed\":" << (allPassed ? "true" : "false") << "}\n";
+			return file.good();
+		}
+
+		bool AllPassed() const { return allPassed; }
+	private:
+		const Options& options;
+		std::vector<Result> results;
+		bool allPassed{ true };
+	};
+
+	// Ids of the nodes of a synthesized graph, in creation order
+	struct GraphNodes {
+		std::vector<std::shared_ptr<ne::ObjectEditorNode<VkAttachmentDescription>>> editors;
+		std::vector<std::shared_ptr<ne::NodeBase>> consumers;
+		// input attributes of consumers, each linked to an editor
+		std::vector<int> inputIds;
+	};
+
+	// Editors get varied values, so that serialized objects and content hashes differ
+	GraphNodes AddNodes(ne::Graph& graph, const Options& options) {
+		GraphNodes nodes;
+		for (int i = 0; i < options.numEditors; ++i) {
+			auto editor = graph.AddNode<ne::ObjectEditorNode<VkAttachmentDescription>>("Attachment", static_cast<VkAttachmentDescriptionFlags>(0),
+				i % 2 == 0 ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_D24_UNORM_S8_UINT, VK_SAMPLE_COUNT_1_BIT);
+			editor->object.finalLayout = i % 2 == 0 ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			editor->object.storeOp = static_cast<VkAttachmentStoreOp>(i % 3 == 0);
+			nodes.editors.push_back(editor);
+		}
+		// a RenderPass has two inputs, hence there are half as many of them
+		const int numConsumers = options.renderPasses ? options.numEditors * options.fanout / 2 : options.numEditors * options.fanout;
+		for (int i = 0; i < numConsumers; ++i) {
+			if (options.renderPasses) {
+				auto renderPass = graph.AddNode<ne::RenderPassNode>();
+				nodes.inputIds.push_back(renderPass->colorInput.id);
+				nodes.inputIds.push_back(renderPass->depthInput.id);
+				nodes.consumers.push_back(renderPass);
+			}
+			else {
+				auto viewer = graph.AddNode<ne::ObjectViewerNode>();
+				nodes.inputIds.push_back(viewer->input.id);
+				nodes.consumers.push_back(viewer);
+			}
+		}
+		return nodes;
+	}
+
+	// Input i is fed by editor (i + shift) % numEditors
+	void AddLinks(ne::Graph& graph, const GraphNodes& nodes, size_t shift = 0) {
+		for (size_t i = 0; i < nodes.inputIds.size(); ++i)
+			graph.AddLink(nodes.editors[(i + shift) % nodes.editors.size()]->output.id, nodes.inputIds[i]);
+	}
+
+	// Nodes on a grid, so that a frame sees a part of them
+	ImVec2 GridPos(int nodeId) {
+		const uint32_t ix = ne::SlotMap<int>::IndexOf(nodeId);
+		return ImVec2{ static_cast<float>(ix % 100) * 250.0f, static_cast<float>(ix / 100) * 350.0f };
+	}
+
+	std::string ReadFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void BenchmarkGraphOperations(Runner& runner, const Options& options) {
+		ne::Graph probe;
+		const GraphNodes probeNodes = AddNodes(probe, options);
+		const size_t numNodes = probeNodes.editors.size() + probeNodes.consumers.size();
+		const size_t numLinks = probeNodes.inputIds.size();
+
+		runner.Measure("graph/add_nodes", numNodes, [&]() {
+			ne::Graph graph;
+			const auto start = std::chrono::steady_clock::now();
+			AddNodes(graph, options);
+			return MillisecondsSince(start);
+		});
+		runner.Measure("graph/add_links", numLinks, [&]() {
+			ne::Graph graph;
+			const GraphNodes nodes = AddNodes(graph, options);
+			const auto start = std::chrono::steady_clock::now();
+			AddLinks(graph, nodes);
+			return MillisecondsSince(start);
+		});
+		// building a graph of 100k links, whatever the size of the other benchmarks, has to take well under a second
+		if (runner.IsSelected("graph/add_links_100k")) {
+			Options largeOptions = options;
+			largeOptions.numEditors = 100000 / options.fanout + 1;
+			ne::Graph graph;
+			const auto start = std::chrono::steady_clock::now();
+			const GraphNodes nodes = AddNodes(graph, largeOptions);
+			AddLinks(graph, nodes);
+			const double duration = MillisecondsSince(start);
+			runner.Check("graph/add_links_100k", graph.links.size() >= 100000 && duration < 1000.0);
+		}
+		// every input is connected already, hence each link replaces one
+		runner.Measure("graph/replace_links", numLinks, [&]() {
+			ne::Graph graph;
+			const GraphNodes nodes = AddNodes(graph, options);
+			AddLinks(graph, nodes);
+			const auto start = std::chrono::steady_clock::now();
+			AddLinks(graph, nodes, 1);
+			return MillisecondsSince(start);
+		});
+		// output to output, and output to value attribute. Rejected by the attribute kind table.
+		bool allRejected{ true };
+		runner.Measure("graph/reject_links", numLinks * 2, [&]() {
+			ne::Graph graph;
+			const GraphNodes nodes = AddNodes(graph, options);
+			const size_t numEditors = nodes.editors.size();
+			size_t numRejected{ 0 };
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < numLinks; ++i) {
+				const auto& from = nodes.editors[i % numEditors];
+				const auto& to = nodes.editors[(i + 1) % numEditors];
+				numRejected += graph.AddLink(from->output.id, to->output.id) == -1;
+				numRejected += graph.AddLink(from->output.id, to->inputs[i % to->inputs.size()].id) == -1;
+			}
+			const double duration = MillisecondsSince(start);
+			allRejected = allRejected && numRejected == numLinks * 2;
+			return duration;
+		});
+		runner.Check("graph/reject_links", allRejected);
+		runner.Measure("graph/remove_links", numLinks, [&]() {
+			ne::Graph graph;
+			const GraphNodes nodes = AddNodes(graph, options);
+			AddLinks(graph, nodes);
+			const std::vector<int> linkIds = graph.links.ids();
+			const auto start = std::chrono::steady_clock::now();
+			for (int linkId : linkIds)
+				graph.RemoveLink(linkId);
+			return MillisecondsSince(start);
+		});
+		// removes the links attached to them too
+		runner.Measure("graph/remove_nodes", probeNodes.editors.size(), [&]() {
+			ne::Graph graph;
+			const GraphNodes nodes = AddNodes(graph, options);
+			AddLinks(graph, nodes);
+			std::vector<int> editorIds;
+			for (const auto& editor : nodes.editors)
+				editorIds.push_back(editor->id);
+			const auto start = std::chrono::steady_clock::now();
+			graph.RemoveNodes(editorIds.data(), editorIds.size());
+			return MillisecondsSince(start);
+		});
+	}
+
+	// Storage of nodes in a SlotMap, against the unordered_map it replaced
+	void BenchmarkNodeStorage(Runner& runner, const Options& options) {
+		ne::Graph graph;
+		AddNodes(graph, options);
+		std::unordered_map<int, std::shared_ptr<ne::NodeBase>> nodeMap;
+		for (const std::shared_ptr<ne::NodeBase>& nd : graph.nodes)
+			nodeMap[nd->id] = nd;
+		std::vector<int> lookupIds = graph.nodes.ids();
+		std::shuffle(lookupIds.begin(), lookupIds.end(), std::mt19937{ 42 });
+		const size_t numNodes = graph.nodes.size();
+		// so that the loops are not optimized away
+		volatile int sink{ 0 };
+
+		runner.Measure("storage/slotmap_iterate", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			int sum{ 0 };
+			for (const std::shared_ptr<ne::NodeBase>& nd : graph.nodes)
+				sum += nd->id;
+			sink = sum;
+			return MillisecondsSince(start);
+		});
+		runner.Measure("storage/unordered_map_iterate", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			int sum{ 0 };
+			for (const auto& [id, nd] : nodeMap)
+				sum += nd->id;
+			sink = sum;
+			return MillisecondsSince(start);
+		});
+		runner.Measure("storage/slotmap_lookup", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			int sum{ 0 };
+			for (int id : lookupIds)
+				sum += graph.nodes.at(id)->id;
+			sink = sum;
+			return MillisecondsSince(start);
+		});
+		runner.Measure("storage/unordered_map_lookup", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			int sum{ 0 };
+			for (int id : lookupIds)
+				sum += nodeMap.at(id)->id;
+			sink = sum;
+			return MillisecondsSince(start);
+		});
+	}
+
+	// Save, load and save again should give the same file
+	void BenchmarkSerialization(Runner& runner, const Options& options) {
+		ne::Graph graph;
+		const GraphNodes nodes = AddNodes(graph, options);
+		AddLinks(graph, nodes);
+		const size_t numNodes = graph.nodes.size();
+		std::unordered_map<int, ImVec2> loadedPositions;
+		const auto getNodePos = [](int nodeId) { return GridPos(nodeId); };
+		const auto setNodePos = [&](int nodeId, ImVec2 pos) { loadedPositions[nodeId] = pos; };
+		const auto getLoadedPos = [&](int nodeId) { return loadedPositions[nodeId]; };
+
+		struct Format {
+			const char* name;
+			const char* path;
+			decltype(&ne::SaveGraph) save;
+			decltype(&ne::LoadGraph) load;
+		};
+		const Format formats[] = {
+			{ "binary", "benchmark_graph.vng", ne::SaveGraph, ne::LoadGraph },
+			{ "json", "benchmark_graph.json", ne::SaveGraphJson, ne::LoadGraphJson },
+		};
+		for (const Format& format : formats) {
+			const std::string prefix{ std::string{ "serialization/" } + format.name };
+			runner.Measure(prefix + "_save", numNodes, [&]() {
+				const auto start = std::chrono::steady_clock::now();
+				format.save(format.path, graph, getNodePos);
+				return MillisecondsSince(start);
+			});
+			runner.Measure(prefix + "_load", numNodes, [&]() {
+				ne::Graph loaded;
+				loadedPositions.clear();
+				const auto start = std::chrono::steady_clock::now();
+				format.load(format.path, loaded, setNodePos);
+				return MillisecondsSince(start);
+			});
+
+			const std::string roundTripPath{ std::string{ format.path } + ".roundtrip" };
+			ne::Graph loaded;
+			loadedPositions.clear();
+			const bool roundTripped = format.save(format.path, graph, getNodePos) && format.load(format.path, loaded, setNodePos)
+				&& format.save(roundTripPath, loaded, getLoadedPos) && ReadFile(format.path) == ReadFile(roundTripPath);
+			runner.Check(prefix + "_roundtrip", roundTripped && loaded.nodes.size() == graph.nodes.size() && loaded.links.size() == graph.links.size());
+			std::remove(format.path);
+			std::remove(roundTripPath.c_str());
+		}
+	}
+
+	// imnodes editor state, i.e. node positions and panning. Needs a current editor context.
+	void BenchmarkEditorState(Runner& runner, const Options& options) {
+		ne::NodeEditor nodeEditor{};
+		const GraphNodes nodes = AddNodes(nodeEditor.graph, options);
+		for (const std::shared_ptr<ne::NodeBase>& nd : nodeEditor.graph.nodes)
+			ImNodes::SetNodeGridSpacePos(nd->id, GridPos(nd->id));
+		const size_t numNodes = nodeEditor.graph.nodes.size();
+
+		std::string ini;
+		runner.Measure("editor_state/save", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			size_t size;
+			const char* data = ImNodes::SaveCurrentEditorStateToIniString(&size);
+			const double duration = MillisecondsSince(start);
+			ini.assign(data, size);
+			return duration;
+		});
+		runner.Measure("editor_state/load", numNodes, [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			ImNodes::LoadCurrentEditorStateFromIniString(ini.data(), ini.size());
+			return MillisecondsSince(start);
+		});
+		size_t size;
+		const char* data = ImNodes::SaveCurrentEditorStateToIniString(&size);
+		runner.Check("editor_state/roundtrip", ini == std::string(data, size));
+	}
+
+	// Wide graph: editors are independent of each other, consumers depend on editors only
+	void BenchmarkEvaluation(Runner& runner, const Options& options) {
+		ne::Graph graph;
+		const GraphNodes nodes = AddNodes(graph, options);
+		AddLinks(graph, nodes);
+		const size_t numNodes = graph.nodes.size();
+		// stands for creating objects of a node, a few microseconds
+		std::atomic<uint64_t> sink{ 0 };
+		const auto evaluateNode = [&sink](ne::NodeBase& nd) {
+			uint64_t hash = nd.contentHash;
+			for (int i = 0; i < 256; ++i)
+				hash = HashBytes(&hash, sizeof(hash), hash);
+			sink.fetch_xor(hash, std::memory_order_relaxed);
+		};
+		// forgets memoized results, so that every node is evaluated
+		const auto markAllChanged = [&]() {
+			for (const std::shared_ptr<ne::NodeBase>& nd : graph.nodes) {
+				nd->contentHash = 0;
+				graph.MarkDirty(nd->id);
+			}
+		};
+
+		graph.Evaluate(evaluateNode);
+		runner.Measure("evaluate/serial", numNodes, [&]() {
+			markAllChanged();
+			const auto start = std::chrono::steady_clock::now();
+			graph.Evaluate(evaluateNode);
+			return MillisecondsSince(start);
+		});
+		// scaling with the number of threads, the calling one included: 1, 2, 4... and all hardware threads
+		const size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		std::vector<size_t> threadCounts;
+		for (size_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+			threadCounts.push_back(numThreads);
+		threadCounts.push_back(maxThreads);
+		for (size_t numThreads : threadCounts) {
+			TaskScheduler scheduler{ numThreads - 1 };
+			runner.Measure("evaluate/parallel_" + std::to_string(numThreads) + "_threads", numNodes, [&]() {
+				markAllChanged();
+				const auto start = std::chrono::steady_clock::now();
+				graph.Evaluate(scheduler, evaluateNode);
+				return MillisecondsSince(start);
+			});
+		}
+		// content didn't change, nothing is evaluated
+		runner.Measure("evaluate/memo_hits", numNodes, [&]() {
+			for (const std::shared_ptr<ne::NodeBase>& nd : graph.nodes)
+				graph.MarkDirty(nd->id);
+			const auto start = std::chrono::steady_clock::now();
+			graph.Evaluate(evaluateNode);
+			return MillisecondsSince(start);
+		});
+		// an edit of one editor, its consumers are evaluated too
+		runner.Measure("evaluate/single_edit", 1, [&]() {
+			const auto& editor = nodes.editors[nodes.editors.size() / 2];
+			editor->object.samples = editor->object.samples == VK_SAMPLE_COUNT_1_BIT ? VK_SAMPLE_COUNT_4_BIT : VK_SAMPLE_COUNT_1_BIT;
+			graph.MarkDirty(editor->id);
+			const auto start = std::chrono::steady_clock::now();
+			graph.Evaluate(evaluateNode);
+			return MillisecondsSince(start);
+		});
+		runner.Check("evaluate/single_edit_count", graph.GetEvaluationStats().lastNumEvaluated == 1 + static_cast<size_t>(options.fanout)
+			|| options.renderPasses);
+	}
+
+	// Whole editor frames through ImGui and imnodes, into CPU-side draw lists
+	void BenchmarkEditorFrames(Runner& runner, const Options& options) {
+		ne::NodeEditor nodeEditor{};
+		const GraphNodes nodes = AddNodes(nodeEditor.graph, options);
+		AddLinks(nodeEditor.graph, nodes);
+		for (const std::shared_ptr<ne::NodeBase>& nd : nodeEditor.graph.nodes)
+			ImNodes::SetNodeGridSpacePos(nd->id, GridPos(nd->id));
+
+		const auto drawFrames = [&]() {
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < options.numFrames; ++i) {
+				FrameArena::Get().Reset();
+				ImGui::NewFrame();
+				nodeEditor.Draw();
+				ImGui::Render();
+			}
+			return MillisecondsSince(start) / options.numFrames;
+		};
+		// first frames create windows and imnodes state of every node
+		runner.Measure("editor/frame", 1, drawFrames);
+		// nodes are drawn with less detail, and many more of them are on the canvas
+		ImNodes::EditorContextSetZoom(0.2f);
+		runner.Measure("editor/frame_zoomed_out", 1, drawFrames);
+		ImNodes::EditorContextSetZoom(1.0f);
+	}
+
+	void PrintUsage(const char* program) {
+		std::cerr << "usage: " << program << " [--editors N] [--fanout N] [--render-passes] [--repeats N] [--frames N]"
+			<< " [--filter name] [--json results.json]" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue{ i + 1 < argc };
+		if (std::strcmp(argv[i], "--editors") == 0 && hasValue)
+			options.numEditors = std::max(std::atoi(argv[++i]), 2);
+		else if (std::strcmp(argv[i], "--fanout") == 0 && hasValue)
+			options.fanout = std::max(std::atoi(argv[++i]), 1);
+		else if (std::strcmp(argv[i], "--render-passes") == 0)
+			options.renderPasses = true;
+		else if (std::strcmp(argv[i], "--repeats") == 0 && hasValue)
+			options.repeats = std::max(std::atoi(argv[++i]), 1);
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+			options.numFrames = std::max(std::atoi(argv[++i]), 1);
+		else if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+			options.filter = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+			options.jsonPath = argv[++i];
+		else {
+			PrintUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Same setup as headless mode. Font atlas has to be built before a frame.
+	ImGui::SetAllocatorFunctions(CountingMalloc, CountingFree);
+	ImGui::CreateContext();
+	ImNodes::CreateContext();
+	ImGuiIO& io{ ImGui::GetIO() };
+	io.IniFilename = nullptr;
+	io.DisplaySize = ImVec2{ 1920.0f, 1080.0f };
+	io.DeltaTime = 1.0f / 60.0f;
+	unsigned char* fontPixels;
+	int fontWidth, fontHeight;
+	io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+
+	Runner runner{ options };
+	BenchmarkGraphOperations(runner, options);
+	BenchmarkNodeStorage(runner, options);
+	BenchmarkSerialization(runner, options);
+	BenchmarkEditorState(runner, options);
+	BenchmarkEvaluation(runner, options);
+	BenchmarkEditorFrames(runner, options);
+
+	ImNodes::DestroyContext();
+	ImGui::DestroyContext();
+
+	if (!options.jsonPath.empty() && !runner.WriteJson(options.jsonPath)) {
+		std::cerr << "Cannot write " << options.jsonPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	return runner.AllPassed() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
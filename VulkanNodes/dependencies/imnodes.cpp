@@ -23,9 +23,9 @@
 #include <math.h>
 #include <new>
 #include <stdint.h>
-#include <stdio.h> // for fwrite, ssprintf, sscanf
-#include <stdlib.h>
-#include <string.h> // strlen, strncmp
+#include <stdio.h> // for fwrite
+#include <stdlib.h> // strtof
+#include <string.h> // strlen, memchr, memcmp
 
 ImNodesContext* GImNodes = NULL;
 
@@ -35,12 +35,6 @@ namespace
 {
 // [SECTION] bezier curve helpers
 
-struct CubicBezier
-{
-    ImVec2 P0, P1, P2, P3;
-    int    NumSegments;
-};
-
 inline ImVec2 EvalCubicBezier(
     const float   t,
     const ImVec2& P0,
@@ -60,47 +54,38 @@ inline ImVec2 EvalCubicBezier(
         b0 * P0.y + b1 * P1.y + b2 * P2.y + b3 * P3.y);
 }
 
-// Calculates the closest point along each bezier curve segment.
-ImVec2 GetClosestPointOnCubicBezier(const int num_segments, const ImVec2& p, const CubicBezier& cb)
+// Calculates the closest point along each segment of the polyline.
+ImVec2 GetClosestPointOnPolyline(const ImVector<ImVec2>& polyline, const ImVec2& p)
 {
-    IM_ASSERT(num_segments > 0);
-    ImVec2 p_last = cb.P0;
+    IM_ASSERT(polyline.Size > 1);
     ImVec2 p_closest;
     float  p_closest_dist = FLT_MAX;
-    float  t_step = 1.0f / (float)num_segments;
-    for (int i = 1; i <= num_segments; ++i)
+    for (int i = 1; i < polyline.Size; ++i)
     {
-        ImVec2 p_current = EvalCubicBezier(t_step * i, cb.P0, cb.P1, cb.P2, cb.P3);
-        ImVec2 p_line = ImLineClosestPoint(p_last, p_current, p);
+        ImVec2 p_line = ImLineClosestPoint(polyline[i - 1], polyline[i], p);
         float  dist = ImLengthSqr(p - p_line);
         if (dist < p_closest_dist)
         {
             p_closest = p_line;
             p_closest_dist = dist;
         }
-        p_last = p_current;
     }
     return p_closest;
 }
 
-inline float GetDistanceToCubicBezier(
-    const ImVec2&      pos,
-    const CubicBezier& cubic_bezier,
-    const int          num_segments)
+inline float GetDistanceToPolyline(const ImVec2& pos, const ImVector<ImVec2>& polyline)
 {
-    const ImVec2 point_on_curve = GetClosestPointOnCubicBezier(num_segments, pos, cubic_bezier);
+    const ImVec2 point_on_curve = GetClosestPointOnPolyline(polyline, pos);
 
     const ImVec2 to_curve = point_on_curve - pos;
     return ImSqrt(ImLengthSqr(to_curve));
 }
 
-inline ImRect GetContainingRectForCubicBezier(const CubicBezier& cb)
+inline ImRect GetContainingRectForCubicBezier(const ImCubicBezier& cb, const float hover_distance)
 {
     const ImVec2 min = ImVec2(ImMin(cb.P0.x, cb.P3.x), ImMin(cb.P0.y, cb.P3.y));
     const ImVec2 max = ImVec2(ImMax(cb.P0.x, cb.P3.x), ImMax(cb.P0.y, cb.P3.y));
 
-    const float hover_distance = GImNodes->Style.LinkHoverDistance;
-
     ImRect rect(min, max);
     rect.Add(cb.P1);
     rect.Add(cb.P2);
@@ -109,7 +94,7 @@ inline ImRect GetContainingRectForCubicBezier(const CubicBezier& cb)
     return rect;
 }
 
-inline CubicBezier GetCubicBezier(
+inline ImCubicBezier GetCubicBezier(
     ImVec2                     start,
     ImVec2                     end,
     const ImNodesAttributeType start_type,
@@ -122,9 +107,9 @@ inline CubicBezier GetCubicBezier(
         ImSwap(start, end);
     }
 
-    const float  link_length = ImSqrt(ImLengthSqr(end - start));
-    const ImVec2 offset = ImVec2(0.25f * link_length, 0.f);
-    CubicBezier  cubic_bezier;
+    const float   link_length = ImSqrt(ImLengthSqr(end - start));
+    const ImVec2  offset = ImVec2(0.25f * link_length, 0.f);
+    ImCubicBezier cubic_bezier;
     cubic_bezier.P0 = start;
     cubic_bezier.P1 = start + offset;
     cubic_bezier.P2 = end - offset;
@@ -133,6 +118,17 @@ inline CubicBezier GetCubicBezier(
     return cubic_bezier;
 }
 
+// Evaluates the curve at NumSegments + 1 evenly spaced parameter values.
+void TessellateCubicBezier(const ImCubicBezier& cb, ImVector<ImVec2>& points)
+{
+    points.resize(cb.NumSegments + 1);
+    const float t_step = 1.0f / (float)cb.NumSegments;
+    for (int i = 0; i <= cb.NumSegments; ++i)
+    {
+        points[i] = EvalCubicBezier(t_step * i, cb.P0, cb.P1, cb.P2, cb.P3);
+    }
+}
+
 inline float EvalImplicitLineEq(const ImVec2& p1, const ImVec2& p2, const ImVec2& p)
 {
     return (p2.y - p1.y) * p.x + (p1.x - p2.x) * p.y + (p2.x * p1.y - p1.x * p2.y);
@@ -189,53 +185,28 @@ inline bool RectangleOverlapsLineSegment(const ImRect& rect, const ImVec2& p1, c
     return abs(sum) != sum_abs;
 }
 
-inline bool RectangleOverlapsBezier(const ImRect& rectangle, const CubicBezier& cubic_bezier)
+inline bool RectangleOverlapsPolyline(const ImRect& rectangle, const ImVector<ImVec2>& polyline)
 {
-    ImVec2 current =
-        EvalCubicBezier(0.f, cubic_bezier.P0, cubic_bezier.P1, cubic_bezier.P2, cubic_bezier.P3);
-    const float dt = 1.0f / cubic_bezier.NumSegments;
-    for (int s = 0; s < cubic_bezier.NumSegments; ++s)
+    for (int i = 1; i < polyline.Size; ++i)
     {
-        ImVec2 next = EvalCubicBezier(
-            static_cast<float>((s + 1) * dt),
-            cubic_bezier.P0,
-            cubic_bezier.P1,
-            cubic_bezier.P2,
-            cubic_bezier.P3);
-        if (RectangleOverlapsLineSegment(rectangle, current, next))
+        if (RectangleOverlapsLineSegment(rectangle, polyline[i - 1], polyline[i]))
         {
             return true;
         }
-        current = next;
     }
     return false;
 }
 
-inline bool RectangleOverlapsLink(
-    const ImRect&              rectangle,
-    const ImVec2&              start,
-    const ImVec2&              end,
-    const ImNodesAttributeType start_type)
+inline bool RectangleOverlapsLink(const ImRect& rectangle, const ImLinkData& link)
 {
     // First level: simple rejection test via rectangle overlap:
 
-    ImRect lrect = ImRect(start, end);
-    if (lrect.Min.x > lrect.Max.x)
-    {
-        ImSwap(lrect.Min.x, lrect.Max.x);
-    }
-
-    if (lrect.Min.y > lrect.Max.y)
-    {
-        ImSwap(lrect.Min.y, lrect.Max.y);
-    }
-
-    if (rectangle.Overlaps(lrect))
+    if (rectangle.Overlaps(link.Geometry.Rect))
     {
         // First, check if either one or both endpoinds are trivially contained
         // in the rectangle
 
-        if (rectangle.Contains(start) || rectangle.Contains(end))
+        if (rectangle.Contains(link.Geometry.StartPos) || rectangle.Contains(link.Geometry.EndPos))
         {
             return true;
         }
@@ -243,9 +214,7 @@ inline bool RectangleOverlapsLink(
         // Second level of refinement: do a more expensive test against the
         // link
 
-        const CubicBezier cubic_bezier =
-            GetCubicBezier(start, end, start_type, GImNodes->Style.LinkLineSegmentsPerLength);
-        return RectangleOverlapsBezier(rectangle, cubic_bezier);
+        return RectangleOverlapsPolyline(rectangle, link.Geometry.Polyline);
     }
 
     return false;
@@ -255,7 +224,7 @@ inline bool RectangleOverlapsLink(
 
 inline ImVec2 ScreenSpaceToGridSpace(const ImNodesEditorContext& editor, const ImVec2& v)
 {
-    return v - GImNodes->CanvasOriginScreenSpace - editor.Panning;
+    return (v - GImNodes->CanvasOriginScreenSpace - editor.Panning) / editor.Zoom;
 }
 
 inline ImRect ScreenSpaceToGridSpace(const ImNodesEditorContext& editor, const ImRect& r)
@@ -265,17 +234,17 @@ inline ImRect ScreenSpaceToGridSpace(const ImNodesEditorContext& editor, const I
 
 inline ImVec2 GridSpaceToScreenSpace(const ImNodesEditorContext& editor, const ImVec2& v)
 {
-    return v + GImNodes->CanvasOriginScreenSpace + editor.Panning;
+    return v * editor.Zoom + GImNodes->CanvasOriginScreenSpace + editor.Panning;
 }
 
 inline ImVec2 GridSpaceToEditorSpace(const ImNodesEditorContext& editor, const ImVec2& v)
 {
-    return v + editor.Panning;
+    return v * editor.Zoom + editor.Panning;
 }
 
 inline ImVec2 EditorSpaceToGridSpace(const ImNodesEditorContext& editor, const ImVec2& v)
 {
-    return v - editor.Panning;
+    return (v - editor.Panning) / editor.Zoom;
 }
 
 inline ImVec2 EditorSpaceToScreenSpace(const ImVec2& v)
@@ -289,19 +258,35 @@ inline ImVec2 MiniMapSpaceToGridSpace(const ImNodesEditorContext& editor, const
            editor.GridContentBounds.Min;
 };
 
-inline ImVec2 ScreenSpaceToMiniMapSpace(const ImNodesEditorContext& editor, const ImVec2& v)
+inline ImVec2 GridSpaceToMiniMapSpace(const ImNodesEditorContext& editor, const ImVec2& v)
 {
-    return (ScreenSpaceToGridSpace(editor, v) - editor.GridContentBounds.Min) *
-               editor.MiniMapScaling +
+    return (v - editor.GridContentBounds.Min) * editor.MiniMapScaling +
            editor.MiniMapContentScreenSpace.Min;
 };
 
+inline ImVec2 ScreenSpaceToMiniMapSpace(const ImNodesEditorContext& editor, const ImVec2& v)
+{
+    return GridSpaceToMiniMapSpace(editor, ScreenSpaceToGridSpace(editor, v));
+};
+
 inline ImRect ScreenSpaceToMiniMapSpace(const ImNodesEditorContext& editor, const ImRect& r)
 {
     return ImRect(
         ScreenSpaceToMiniMapSpace(editor, r.Min), ScreenSpaceToMiniMapSpace(editor, r.Max));
 };
 
+// Moves a rect laid out relative to old_origin so that it is relative to new_origin, scaled by
+// scale
+inline ImRect RemapRect(
+    const ImRect& r,
+    const ImVec2& old_origin,
+    const ImVec2& new_origin,
+    const float   scale)
+{
+    return ImRect(
+        new_origin + (r.Min - old_origin) * scale, new_origin + (r.Max - old_origin) * scale);
+}
+
 // [SECTION] draw list helper
 
 void ImDrawListGrowChannels(ImDrawList* draw_list, const int num_channels)
@@ -682,6 +667,17 @@ void BeginLinkInteraction(
 
 static inline bool IsMiniMapHovered();
 
+// Zoom factor change per mouse wheel step
+static const float MOUSE_WHEEL_ZOOM_STEP = 1.1f;
+
+// Changes the zoom factor, keeping the grid-space point under the screen-space pivot in place
+void ZoomAroundScreenSpacePoint(ImNodesEditorContext& editor, const float zoom, const ImVec2& pivot)
+{
+    const ImVec2 grid_pivot = ScreenSpaceToGridSpace(editor, pivot);
+    editor.Zoom = zoom;
+    editor.Panning = pivot - GImNodes->CanvasOriginScreenSpace - grid_pivot * zoom;
+}
+
 void BeginCanvasInteraction(ImNodesEditorContext& editor)
 {
     const bool any_ui_element_hovered =
@@ -748,24 +744,17 @@ void BoxSelectorUpdateSelection(ImNodesEditorContext& editor, ImRect box_rect)
 
     // Test for overlap against links
 
+    // Link geometry is cached in grid space
+    const ImRect grid_box_rect = ScreenSpaceToGridSpace(editor, box_rect);
+
     for (int link_idx = 0; link_idx < editor.Links.Pool.size(); ++link_idx)
     {
         if (editor.Links.InUse[link_idx])
         {
             const ImLinkData& link = editor.Links.Pool[link_idx];
 
-            const ImPinData& pin_start = editor.Pins.Pool[link.StartPinIdx];
-            const ImPinData& pin_end = editor.Pins.Pool[link.EndPinIdx];
-            const ImRect&    node_start_rect = editor.Nodes.Pool[pin_start.ParentNodeIdx].Rect;
-            const ImRect&    node_end_rect = editor.Nodes.Pool[pin_end.ParentNodeIdx].Rect;
-
-            const ImVec2 start = GetScreenSpacePinCoordinates(
-                node_start_rect, pin_start.AttributeRect, pin_start.Type);
-            const ImVec2 end =
-                GetScreenSpacePinCoordinates(node_end_rect, pin_end.AttributeRect, pin_end.Type);
-
             // Test
-            if (RectangleOverlapsLink(box_rect, start, end, pin_start.Type))
+            if (!link.Geometry.Polyline.empty() && RectangleOverlapsLink(grid_box_rect, link))
             {
                 editor.SelectedLinkIndices.push_back(link_idx);
             }
@@ -784,7 +773,7 @@ void TranslateSelectedNodes(ImNodesEditorContext& editor)
             ImNodeData& node = editor.Nodes.Pool[node_idx];
             if (node.Draggable)
             {
-                node.Origin += io.MouseDelta - editor.AutoPanningDelta;
+                node.Origin += (io.MouseDelta - editor.AutoPanningDelta) / editor.Zoom;
             }
         }
     }
@@ -982,7 +971,7 @@ void ClickInteractionUpdate(ImNodesEditorContext& editor)
                                          editor, editor.Pins.Pool[GImNodes->HoveredPinIdx.Value()])
                                    : GImNodes->MousePos;
 
-        const CubicBezier cubic_bezier = GetCubicBezier(
+        const ImCubicBezier cubic_bezier = GetCubicBezier(
             start_pos, end_pos, start_pin.Type, GImNodes->Style.LinkLineSegmentsPerLength);
 #if IMGUI_VERSION_NUM < 18000
         GImNodes->CanvasDrawList->AddBezierCurve(
@@ -1063,82 +1052,676 @@ void ClickInteractionUpdate(ImNodesEditorContext& editor)
     }
 }
 
-void ResolveOccludedPins(const ImNodesEditorContext& editor, ImVector<int>& occluded_pin_indices)
+// [SECTION] spatial index
+
+// Upper bound of cells a single object may be inserted into before it is treated as oversized.
+static const int SPATIAL_GRID_MAX_CELLS_PER_OBJECT = 64;
+// Preferred cell size in grid space. Cells grow when there is little content spread out far.
+static const float SPATIAL_GRID_CELL_SIZE = 128.f;
+
+inline bool RectsEqual(const ImRect& lhs, const ImRect& rhs)
 {
-    const ImVector<int>& depth_stack = editor.NodeDepthOrder;
+    return lhs.Min.x == rhs.Min.x && lhs.Min.y == rhs.Min.y && lhs.Max.x == rhs.Max.x &&
+           lhs.Max.y == rhs.Max.y;
+}
 
-    occluded_pin_indices.resize(0);
+inline bool Vec2sEqual(const ImVec2& lhs, const ImVec2& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
 
-    if (depth_stack.Size < 2)
+inline int SpatialGridCellCoord(
+    const float v,
+    const float min,
+    const float cell_size,
+    const int   count)
+{
+    // Clamp in floating point first, the coordinates can be arbitrarily far outside of the bounds
+    return static_cast<int>(ImClamp((v - min) / cell_size, 0.f, static_cast<float>(count - 1)));
+}
+
+// Returns false if the rectangle covers too many cells to be inserted into each of them.
+bool SpatialGridCellRange(
+    const ImSpatialGrid& grid,
+    const ImRect&        rect,
+    int* const           x0,
+    int* const           y0,
+    int* const           x1,
+    int* const           y1)
+{
+    *x0 = SpatialGridCellCoord(rect.Min.x, grid.Bounds.Min.x, grid.CellSize, grid.Width);
+    *x1 = SpatialGridCellCoord(rect.Max.x, grid.Bounds.Min.x, grid.CellSize, grid.Width);
+    *y0 = SpatialGridCellCoord(rect.Min.y, grid.Bounds.Min.y, grid.CellSize, grid.Height);
+    *y1 = SpatialGridCellCoord(rect.Max.y, grid.Bounds.Min.y, grid.CellSize, grid.Height);
+    return (*x1 - *x0 + 1) * (*y1 - *y0 + 1) <= SPATIAL_GRID_MAX_CELLS_PER_OBJECT;
+}
+
+// Empties the grid, and lays out its cells over the bounds.
+void SpatialGridReset(ImSpatialGrid& grid, const ImRect& bounds, const float cell_size)
+{
+    grid.Bounds = bounds;
+    grid.CellSize = cell_size;
+    grid.Width = ImMax(static_cast<int>(ceilf(bounds.GetWidth() / cell_size)), 1);
+    grid.Height = ImMax(static_cast<int>(ceilf(bounds.GetHeight() / cell_size)), 1);
+
+    grid.CellHeads.resize(grid.Width * grid.Height);
+    memset(grid.CellHeads.Data, 0xff, grid.CellHeads.size_in_bytes());
+    grid.Entries.resize(0);
+    grid.FreeEntry = -1;
+    for (int i = 0; i < grid.Objects.Size; ++i)
+    {
+        grid.Objects[i].FirstEntry = -1;
+        grid.Objects[i].Oversized = false;
+    }
+    grid.Oversized.resize(0);
+    grid.NumObjects = 0;
+}
+
+inline bool SpatialGridContains(const ImSpatialGrid& grid, const int idx)
+{
+    return idx < grid.Objects.Size &&
+           (grid.Objects[idx].FirstEntry != -1 || grid.Objects[idx].Oversized);
+}
+
+void SpatialGridRemove(ImSpatialGrid& grid, const int idx)
+{
+    if (!SpatialGridContains(grid, idx))
     {
         return;
     }
 
-    // For each node in the depth stack
-    for (int depth_idx = 0; depth_idx < (depth_stack.Size - 1); ++depth_idx)
+    ImSpatialGridObject& object = grid.Objects[idx];
+    if (object.Oversized)
+    {
+        grid.Oversized.find_erase_unsorted(idx);
+        object.Oversized = false;
+    }
+
+    for (int entry_idx = object.FirstEntry; entry_idx != -1;)
+    {
+        ImSpatialGridEntry& entry = grid.Entries[entry_idx];
+        if (entry.PrevInCell != -1)
+        {
+            grid.Entries[entry.PrevInCell].NextInCell = entry.NextInCell;
+        }
+        else
+        {
+            grid.CellHeads[entry.Cell] = entry.NextInCell;
+        }
+        if (entry.NextInCell != -1)
+        {
+            grid.Entries[entry.NextInCell].PrevInCell = entry.PrevInCell;
+        }
+
+        const int next_entry_idx = entry.NextOfObject;
+        entry.NextInCell = grid.FreeEntry;
+        grid.FreeEntry = entry_idx;
+        entry_idx = next_entry_idx;
+    }
+    object.FirstEntry = -1;
+    --grid.NumObjects;
+}
+
+// Inserts the object, or moves it if it is in the grid already. An object which stays in the same
+// cells is left untouched.
+void SpatialGridUpdate(ImSpatialGrid& grid, const ImRect& rect, const int idx)
+{
+    int        x0, y0, x1, y1;
+    const bool oversized = !SpatialGridCellRange(grid, rect, &x0, &y0, &x1, &y1);
+
+    if (SpatialGridContains(grid, idx))
+    {
+        const ImSpatialGridObject& object = grid.Objects[idx];
+        if (oversized ? object.Oversized
+                      : !object.Oversized && object.X0 == x0 && object.Y0 == y0 &&
+                            object.X1 == x1 && object.Y1 == y1)
+        {
+            return;
+        }
+        SpatialGridRemove(grid, idx);
+    }
+
+    while (grid.Objects.Size <= idx)
+    {
+        ImSpatialGridObject object;
+        object.X0 = object.Y0 = object.X1 = object.Y1 = 0;
+        object.FirstEntry = -1;
+        object.Oversized = false;
+        grid.Objects.push_back(object);
+    }
+
+    ImSpatialGridObject& object = grid.Objects[idx];
+    object.X0 = x0;
+    object.Y0 = y0;
+    object.X1 = x1;
+    object.Y1 = y1;
+    ++grid.NumObjects;
+    if (oversized)
+    {
+        object.Oversized = true;
+        grid.Oversized.push_back(idx);
+        return;
+    }
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            int entry_idx = grid.FreeEntry;
+            if (entry_idx != -1)
+            {
+                grid.FreeEntry = grid.Entries[entry_idx].NextInCell;
+            }
+            else
+            {
+                entry_idx = grid.Entries.Size;
+                grid.Entries.push_back(ImSpatialGridEntry());
+            }
+
+            const int           cell = y * grid.Width + x;
+            ImSpatialGridEntry& entry = grid.Entries[entry_idx];
+            entry.ObjectIdx = idx;
+            entry.Cell = cell;
+            entry.PrevInCell = -1;
+            entry.NextInCell = grid.CellHeads[cell];
+            entry.NextOfObject = object.FirstEntry;
+            if (entry.NextInCell != -1)
+            {
+                grid.Entries[entry.NextInCell].PrevInCell = entry_idx;
+            }
+            grid.CellHeads[cell] = entry_idx;
+            object.FirstEntry = entry_idx;
+        }
+    }
+}
+
+// Collects the indices of all objects whose rectangle might contain the grid-space point. They are
+// not in any particular order.
+void SpatialGridQuery(const ImSpatialGrid& grid, const ImVec2& point, ImVector<int>& candidates)
+{
+    candidates.resize(0);
+
+    if (grid.CellHeads.empty())
+    {
+        return;
+    }
+
+    const int x = SpatialGridCellCoord(point.x, grid.Bounds.Min.x, grid.CellSize, grid.Width);
+    const int y = SpatialGridCellCoord(point.y, grid.Bounds.Min.y, grid.CellSize, grid.Height);
+
+    for (int entry_idx = grid.CellHeads[y * grid.Width + x]; entry_idx != -1;
+         entry_idx = grid.Entries[entry_idx].NextInCell)
+    {
+        candidates.push_back(grid.Entries[entry_idx].ObjectIdx);
+    }
+
+    for (int i = 0; i < grid.Oversized.Size; ++i)
+    {
+        candidates.push_back(grid.Oversized[i]);
+    }
+}
+
+// Regenerates the cached geometry of a link if one of its pins moved, or if a style variable the
+// geometry depends on changed. Returns true if the geometry was regenerated.
+bool LinkGeometryUpdate(
+    const ImNodesEditorContext& editor,
+    ImLinkData&                 link,
+    const ImPinData&            start_pin,
+    const ImPinData&            end_pin)
+{
+    const float line_segments_per_length = GImNodes->Style.LinkLineSegmentsPerLength;
+    // The hover distance is given in screen space
+    const float hover_distance = GImNodes->Style.LinkHoverDistance / editor.Zoom;
+
+    if (!link.Geometry.Polyline.empty() && Vec2sEqual(link.Geometry.StartPos, start_pin.GridPos) &&
+        Vec2sEqual(link.Geometry.EndPos, end_pin.GridPos) &&
+        link.Geometry.StartType == start_pin.Type &&
+        link.Geometry.LineSegmentsPerLength == line_segments_per_length &&
+        link.Geometry.HoverDistance == hover_distance)
+    {
+        return false;
+    }
+
+    link.Geometry.StartPos = start_pin.GridPos;
+    link.Geometry.EndPos = end_pin.GridPos;
+    link.Geometry.StartType = start_pin.Type;
+    link.Geometry.LineSegmentsPerLength = line_segments_per_length;
+    link.Geometry.HoverDistance = hover_distance;
+
+    link.Geometry.Bezier = GetCubicBezier(
+        start_pin.GridPos, end_pin.GridPos, start_pin.Type, line_segments_per_length);
+    link.Geometry.Rect = GetContainingRectForCubicBezier(link.Geometry.Bezier, hover_distance);
+    TessellateCubicBezier(link.Geometry.Bezier, link.Geometry.Polyline);
+    return true;
+}
+
+inline ImRect GetPinHoverRect(const ImPinData& pin, const float hover_radius)
+{
+    ImRect pin_rect(pin.GridPos, pin.GridPos);
+    pin_rect.Expand(hover_radius);
+    return pin_rect;
+}
+
+// Pins can be marked as used by Link() without their node being submitted. Those don't have a
+// valid position, and are left out of the index, as are the links attached to them.
+inline bool PinIndexed(const ImNodesEditorContext& editor, const int pin_idx)
+{
+    const int parent_node_idx = editor.Pins.Pool[pin_idx].ParentNodeIdx;
+    return editor.Pins.InUse[pin_idx] && editor.Nodes.InUse[parent_node_idx] &&
+           editor.Nodes.Pool[parent_node_idx].PinIndices.contains(pin_idx);
+}
+
+inline bool LinkIndexed(const ImNodesEditorContext& editor, const int link_idx)
+{
+    const ImLinkData& link = editor.Links.Pool[link_idx];
+    return editor.Links.InUse[link_idx] && PinIndexed(editor, link.StartPinIdx) &&
+           PinIndexed(editor, link.EndPinIdx);
+}
+
+// Brings the grid-space geometry of a node laid out by BeginNode()/EndNode(), and of its pins, up
+// to date with the layout, and records what changed for the spatial index.
+void NodeGeometryUpdate(ImNodesEditorContext& editor, const int node_idx)
+{
+    ImSpatialIndex& index = editor.SpatialIndex;
+    ImNodeData&     node = editor.Nodes.Pool[node_idx];
+
+    const ImRect grid_rect = ScreenSpaceToGridSpace(editor, node.Rect);
+    if (!RectsEqual(grid_rect, node.GridRect) || !SpatialGridContains(index.Nodes, node_idx))
+    {
+        node.GridRect = grid_rect;
+        index.ChangedNodes.push_back(node_idx);
+    }
+    node.GridOrigin = node.Origin;
+
+    for (int i = 0; i < node.PinIndices.size(); ++i)
+    {
+        const int    pin_idx = node.PinIndices[i];
+        ImPinData&   pin = editor.Pins.Pool[pin_idx];
+        const ImVec2 grid_pos = ScreenSpaceToGridSpace(
+            editor, GetScreenSpacePinCoordinates(node.Rect, pin.AttributeRect, pin.Type));
+        if (!Vec2sEqual(grid_pos, pin.GridPos) || !SpatialGridContains(index.Pins, pin_idx))
+        {
+            pin.GridPos = grid_pos;
+            index.ChangedPins.push_back(pin_idx);
+        }
+    }
+
+    ++index.NumSubmittedNodes;
+    index.NumSubmittedPins += node.PinIndices.size();
+}
+
+// A placeholder keeps its last layout, hence its geometry only moves with its origin.
+void PlaceholderGeometryUpdate(ImNodesEditorContext& editor, const int node_idx)
+{
+    ImSpatialIndex& index = editor.SpatialIndex;
+    ImNodeData&     node = editor.Nodes.Pool[node_idx];
+
+    if (!Vec2sEqual(node.Origin, node.GridOrigin))
+    {
+        const ImVec2 delta = node.Origin - node.GridOrigin;
+        node.GridRect.Min += delta;
+        node.GridRect.Max += delta;
+        node.GridOrigin = node.Origin;
+        index.ChangedNodes.push_back(node_idx);
+
+        for (int i = 0; i < node.PinIndices.size(); ++i)
+        {
+            const int pin_idx = node.PinIndices[i];
+            editor.Pins.Pool[pin_idx].GridPos += delta;
+            index.ChangedPins.push_back(pin_idx);
+        }
+    }
+
+    ++index.NumSubmittedNodes;
+    index.NumSubmittedPins += node.PinIndices.size();
+}
+
+// Regenerates the lookup of links attached to each pin.
+void PinLinksUpdate(ImNodesEditorContext& editor)
+{
+    ImSpatialIndex& index = editor.SpatialIndex;
+    const int       num_pins = editor.Pins.Pool.size();
+
+    index.PinLinkStart.resize(num_pins + 1);
+    memset(index.PinLinkStart.Data, 0, index.PinLinkStart.size_in_bytes());
+    for (int link_idx = 0; link_idx < editor.Links.Pool.size(); ++link_idx)
+    {
+        if (editor.Links.InUse[link_idx])
+        {
+            const ImLinkData& link = editor.Links.Pool[link_idx];
+            ++index.PinLinkStart[link.StartPinIdx];
+            ++index.PinLinkStart[link.EndPinIdx];
+        }
+    }
+
+    // The prefix sum turns the counts into the end offsets of each pin. Filling each pin's range
+    // backwards leaves its start offset behind.
+    for (int pin_idx = 1; pin_idx <= num_pins; ++pin_idx)
+    {
+        index.PinLinkStart[pin_idx] += index.PinLinkStart[pin_idx - 1];
+    }
+
+    index.PinLinks.resize(index.PinLinkStart[num_pins]);
+    for (int link_idx = 0; link_idx < editor.Links.Pool.size(); ++link_idx)
     {
-        const ImNodeData& node_below = editor.Nodes.Pool[depth_stack[depth_idx]];
+        if (editor.Links.InUse[link_idx])
+        {
+            const ImLinkData& link = editor.Links.Pool[link_idx];
+            index.PinLinks[--index.PinLinkStart[link.StartPinIdx]] = link_idx;
+            index.PinLinks[--index.PinLinkStart[link.EndPinIdx]] = link_idx;
+        }
+    }
+}
+
+// Builds the spatial index from scratch, over the bounds of all nodes.
+void SpatialIndexRebuild(ImNodesEditorContext& editor)
+{
+    ImSpatialIndex& index = editor.SpatialIndex;
+
+    ImRect bounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+    int    num_nodes = 0;
+    for (int node_idx = 0; node_idx < editor.Nodes.Pool.size(); ++node_idx)
+    {
+        if (editor.Nodes.InUse[node_idx])
+        {
+            bounds.Add(editor.Nodes.Pool[node_idx].GridRect);
+            ++num_nodes;
+        }
+    }
+
+    if (bounds.IsInverted())
+    {
+        bounds = ImRect(0.f, 0.f, SPATIAL_GRID_CELL_SIZE, SPATIAL_GRID_CELL_SIZE);
+    }
+    // Leave room around the nodes, so that dragging one of them a bit outwards doesn't rebuild
+    bounds.Expand(ImMax(bounds.GetWidth(), bounds.GetHeight()) * 0.25f);
+
+    // Keep the number of cells proportional to the number of nodes, so that memory use and build
+    // time don't blow up when a few nodes are spread out very far.
+    const float max_num_cells = static_cast<float>(ImMax(4 * num_nodes, 64));
+    const float cell_size = ImMax(
+        SPATIAL_GRID_CELL_SIZE, ImSqrt(bounds.GetWidth() * bounds.GetHeight() / max_num_cells));
+
+    SpatialGridReset(index.Nodes, bounds, cell_size);
+    SpatialGridReset(index.Pins, bounds, cell_size);
+    SpatialGridReset(index.Links, bounds, cell_size);
+
+    for (int node_idx = 0; node_idx < editor.Nodes.Pool.size(); ++node_idx)
+    {
+        if (editor.Nodes.InUse[node_idx])
+        {
+            SpatialGridUpdate(index.Nodes, editor.Nodes.Pool[node_idx].GridRect, node_idx);
+        }
+    }
+
+    for (int pin_idx = 0; pin_idx < editor.Pins.Pool.size(); ++pin_idx)
+    {
+        if (PinIndexed(editor, pin_idx))
+        {
+            SpatialGridUpdate(
+                index.Pins, GetPinHoverRect(editor.Pins.Pool[pin_idx], index.PinHoverRadius), pin_idx);
+        }
+    }
+
+    for (int link_idx = 0; link_idx < editor.Links.Pool.size(); ++link_idx)
+    {
+        if (LinkIndexed(editor, link_idx))
+        {
+            SpatialGridUpdate(index.Links, editor.Links.Pool[link_idx].Geometry.Rect, link_idx);
+        }
+    }
+
+    index.NodeCapacity = editor.Nodes.Pool.size();
+}
+
+// Brings link geometry and the spatial index up to date with the geometry changes recorded while
+// nodes and links were submitted this frame. The work is proportional to what changed, except for
+// the rare frames which rebuild. Everything is stored in grid space, so panning the editor doesn't
+// invalidate anything.
+void EditorGeometryUpdate(ImNodesEditorContext& editor)
+{
+    ImSpatialIndex& index = editor.SpatialIndex;
+
+    const float pin_hover_radius = GImNodes->Style.PinHoverRadius / editor.Zoom;
+    const float link_hover_distance = GImNodes->Style.LinkHoverDistance / editor.Zoom;
+    const float line_segments_per_length = GImNodes->Style.LinkLineSegmentsPerLength;
+
+    if (index.LinksReconnected)
+    {
+        PinLinksUpdate(editor);
+    }
+
+    // Zooming changes the hover distances, and with them the rectangles of all pins and links
+    bool rebuild = index.NodeCapacity < editor.Nodes.Pool.size() ||
+                   index.PinHoverRadius != pin_hover_radius ||
+                   index.LinkHoverDistance != link_hover_distance ||
+                   index.LinkLineSegmentsPerLength != line_segments_per_length;
+    index.PinHoverRadius = pin_hover_radius;
+    index.LinkHoverDistance = link_hover_distance;
+    index.LinkLineSegmentsPerLength = line_segments_per_length;
+
+    if (rebuild)
+    {
+        for (int link_idx = 0; link_idx < editor.Links.Pool.size(); ++link_idx)
+        {
+            if (LinkIndexed(editor, link_idx))
+            {
+                ImLinkData& link = editor.Links.Pool[link_idx];
+                LinkGeometryUpdate(
+                    editor, link, editor.Pins.Pool[link.StartPinIdx],
+                    editor.Pins.Pool[link.EndPinIdx]);
+            }
+        }
+    }
+    else
+    {
+        // The geometry of links attached to pins without a node keeps whatever it was last
+        // generated from
+        for (int i = 0; i < index.ChangedPins.Size; ++i)
+        {
+            // Pins added since the lookup was built have no links yet
+            const int pin_idx = index.ChangedPins[i];
+            if (pin_idx + 1 >= index.PinLinkStart.Size)
+            {
+                continue;
+            }
+            for (int j = index.PinLinkStart[pin_idx]; j < index.PinLinkStart[pin_idx + 1]; ++j)
+            {
+                index.ChangedLinks.push_back(index.PinLinks[j]);
+            }
+        }
+        for (int i = 0; i < index.ChangedLinks.Size; ++i)
+        {
+            const int link_idx = index.ChangedLinks[i];
+            if (LinkIndexed(editor, link_idx))
+            {
+                ImLinkData& link = editor.Links.Pool[link_idx];
+                LinkGeometryUpdate(
+                    editor, link, editor.Pins.Pool[link.StartPinIdx],
+                    editor.Pins.Pool[link.EndPinIdx]);
+            }
+        }
 
-        // Iterate over the rest of the depth stack to find nodes overlapping the pins
-        for (int next_depth_idx = depth_idx + 1; next_depth_idx < depth_stack.Size;
-             ++next_depth_idx)
+        for (int i = 0; i < index.ChangedNodes.Size && !rebuild; ++i)
         {
-            const ImRect& rect_above = editor.Nodes.Pool[depth_stack[next_depth_idx]].Rect;
+            rebuild = !index.Nodes.Bounds.Contains(editor.Nodes.Pool[index.ChangedNodes[i]].GridRect);
+        }
+    }
 
-            // Iterate over each pin
-            for (int idx = 0; idx < node_below.PinIndices.Size; ++idx)
+    if (rebuild)
+    {
+        SpatialIndexRebuild(editor);
+    }
+    else
+    {
+        for (int i = 0; i < index.ChangedNodes.Size; ++i)
+        {
+            const int node_idx = index.ChangedNodes[i];
+            SpatialGridUpdate(index.Nodes, editor.Nodes.Pool[node_idx].GridRect, node_idx);
+        }
+        for (int i = 0; i < index.ChangedPins.Size; ++i)
+        {
+            const int pin_idx = index.ChangedPins[i];
+            SpatialGridUpdate(
+                index.Pins, GetPinHoverRect(editor.Pins.Pool[pin_idx], pin_hover_radius), pin_idx);
+        }
+        for (int i = 0; i < index.ChangedLinks.Size; ++i)
+        {
+            const int link_idx = index.ChangedLinks[i];
+            if (LinkIndexed(editor, link_idx))
+            {
+                SpatialGridUpdate(index.Links, editor.Links.Pool[link_idx].Geometry.Rect, link_idx);
+            }
+            else
             {
-                const int     pin_idx = node_below.PinIndices[idx];
-                const ImVec2& pin_pos = editor.Pins.Pool[pin_idx].Pos;
+                SpatialGridRemove(index.Links, link_idx);
+            }
+        }
 
-                if (rect_above.Contains(pin_pos))
+        // Objects which were not submitted this frame are still in the grids. Counting is enough
+        // to tell whether there are any, so they are only looked for in frames which removed some.
+        const bool nodes_removed = index.Nodes.NumObjects > index.NumSubmittedNodes;
+        if (nodes_removed)
+        {
+            for (int node_idx = 0; node_idx < index.Nodes.Objects.Size; ++node_idx)
+            {
+                if (!editor.Nodes.InUse[node_idx])
+                {
+                    SpatialGridRemove(index.Nodes, node_idx);
+                }
+            }
+        }
+        const bool pins_removed = index.Pins.NumObjects > index.NumSubmittedPins;
+        if (pins_removed)
+        {
+            for (int pin_idx = 0; pin_idx < index.Pins.Objects.Size; ++pin_idx)
+            {
+                if (!PinIndexed(editor, pin_idx))
                 {
-                    occluded_pin_indices.push_back(pin_idx);
+                    SpatialGridRemove(index.Pins, pin_idx);
+                }
+            }
+        }
+        if (nodes_removed || pins_removed || index.LinksReconnected ||
+            index.NumSubmittedLinks != index.NumPreviousLinks)
+        {
+            for (int link_idx = 0; link_idx < index.Links.Objects.Size; ++link_idx)
+            {
+                if (!LinkIndexed(editor, link_idx))
+                {
+                    SpatialGridRemove(index.Links, link_idx);
                 }
             }
         }
     }
+
+    index.ChangedNodes.resize(0);
+    index.ChangedPins.resize(0);
+    index.ChangedLinks.resize(0);
+    index.LinksReconnected = false;
+    index.NumPreviousLinks = index.NumSubmittedLinks;
+    index.NumSubmittedNodes = 0;
+    index.NumSubmittedPins = 0;
+    index.NumSubmittedLinks = 0;
 }
 
-ImOptionalIndex ResolveHoveredPin(
-    const ImObjectPool<ImPinData>& pins,
-    const ImVector<int>&           occluded_pin_indices)
+// Maps every node index to its position in the depth stack, so that the depth of a node can be
+// looked up in constant time during hover resolution.
+void UpdateNodeDepthLookup(
+    const ImNodesEditorContext& editor,
+    ImVector<int>&              node_idx_to_depth_idx)
 {
-    float           smallest_distance = FLT_MAX;
-    ImOptionalIndex pin_idx_with_smallest_distance;
+    const ImVector<int>& depth_stack = editor.NodeDepthOrder;
+
+    node_idx_to_depth_idx.resize(editor.Nodes.Pool.size());
+    if (!node_idx_to_depth_idx.empty())
+    {
+        // Node slots which are not on the depth stack get the depth -1
+        memset(node_idx_to_depth_idx.Data, 0xff, node_idx_to_depth_idx.size_in_bytes());
+    }
+
+    for (int depth_idx = 0; depth_idx < depth_stack.Size; ++depth_idx)
+    {
+        node_idx_to_depth_idx[depth_stack[depth_idx]] = depth_idx;
+    }
+}
 
-    const float hover_radius_sqr = GImNodes->Style.PinHoverRadius * GImNodes->Style.PinHoverRadius;
+bool IsPinOccluded(
+    const ImNodesEditorContext& editor,
+    const ImVector<int>&        node_idx_to_depth_idx,
+    const ImPinData&            pin)
+{
+    // A pin is occluded if a node higher up in the depth stack than its parent node contains it
+    const int      parent_depth_idx = node_idx_to_depth_idx[pin.ParentNodeIdx];
+    ImVector<int>& occluders = GImNodes->SpatialQueryOccluders;
+    SpatialGridQuery(editor.SpatialIndex.Nodes, pin.GridPos, occluders);
 
-    for (int idx = 0; idx < pins.Pool.Size; ++idx)
+    for (int i = 0; i < occluders.Size; ++i)
     {
-        if (!pins.InUse[idx])
+        const int node_idx = occluders[i];
+        if (editor.Nodes.InUse[node_idx] && node_idx_to_depth_idx[node_idx] > parent_depth_idx &&
+            editor.Nodes.Pool[node_idx].GridRect.Contains(pin.GridPos))
         {
-            continue;
+            return true;
         }
+    }
 
-        if (occluded_pin_indices.contains(idx))
+    return false;
+}
+
+ImOptionalIndex ResolveHoveredPin(
+    const ImNodesEditorContext& editor,
+    const ImVector<int>&        node_idx_to_depth_idx)
+{
+    float           smallest_distance = FLT_MAX;
+    ImOptionalIndex pin_idx_with_smallest_distance;
+
+    const float hover_radius = GImNodes->Style.PinHoverRadius / editor.Zoom;
+    const float hover_radius_sqr = hover_radius * hover_radius;
+
+    const ImVec2   mouse_pos = ScreenSpaceToGridSpace(editor, GImNodes->MousePos);
+    ImVector<int>& candidates = GImNodes->SpatialQueryCandidates;
+    SpatialGridQuery(editor.SpatialIndex.Pins, mouse_pos, candidates);
+
+    for (int i = 0; i < candidates.Size; ++i)
+    {
+        const int idx = candidates[i];
+        if (!editor.Pins.InUse[idx])
         {
             continue;
         }
 
-        const ImVec2& pin_pos = pins.Pool[idx].Pos;
-        const float   distance_sqr = ImLengthSqr(pin_pos - GImNodes->MousePos);
+        const ImPinData& pin = editor.Pins.Pool[idx];
+        const float      distance_sqr = ImLengthSqr(pin.GridPos - mouse_pos);
 
         // TODO: GImNodes->Style.PinHoverRadius needs to be copied into pin data and the pin-local
         // value used here. This is no longer called in BeginAttribute/EndAttribute scope and the
         // detected pin might have a different hover radius than what the user had when calling
         // BeginAttribute/EndAttribute.
-        if (distance_sqr < hover_radius_sqr && distance_sqr < smallest_distance)
+        if (distance_sqr >= hover_radius_sqr || distance_sqr > smallest_distance)
         {
-            smallest_distance = distance_sqr;
-            pin_idx_with_smallest_distance = idx;
+            continue;
         }
+
+        // Candidates are not strictly in index order, so ties are broken by index explicitly
+        if (distance_sqr == smallest_distance && idx > pin_idx_with_smallest_distance.Value())
+        {
+            continue;
+        }
+
+        if (IsPinOccluded(editor, node_idx_to_depth_idx, pin))
+        {
+            continue;
+        }
+
+        smallest_distance = distance_sqr;
+        pin_idx_with_smallest_distance = idx;
     }
 
     return pin_idx_with_smallest_distance;
 }
 
-ImOptionalIndex ResolveHoveredNode(const ImVector<int>& depth_stack)
+ImOptionalIndex ResolveHoveredNode(const ImVector<int>& node_idx_to_depth_idx)
 {
     if (GImNodes->NodeIndicesOverlappingWithMouse.size() == 0)
     {
@@ -1156,13 +1739,11 @@ ImOptionalIndex ResolveHoveredNode(const ImVector<int>& depth_stack)
     for (int i = 0; i < GImNodes->NodeIndicesOverlappingWithMouse.size(); ++i)
     {
         const int node_idx = GImNodes->NodeIndicesOverlappingWithMouse[i];
-        for (int depth_idx = 0; depth_idx < depth_stack.size(); ++depth_idx)
+        const int depth_idx = node_idx_to_depth_idx[node_idx];
+        if (depth_idx > largest_depth_idx)
         {
-            if (depth_stack[depth_idx] == node_idx && (depth_idx > largest_depth_idx))
-            {
-                largest_depth_idx = depth_idx;
-                node_idx_on_top = node_idx;
-            }
+            largest_depth_idx = depth_idx;
+            node_idx_on_top = node_idx;
         }
     }
 
@@ -1170,9 +1751,7 @@ ImOptionalIndex ResolveHoveredNode(const ImVector<int>& depth_stack)
     return ImOptionalIndex(node_idx_on_top);
 }
 
-ImOptionalIndex ResolveHoveredLink(
-    const ImObjectPool<ImLinkData>& links,
-    const ImObjectPool<ImPinData>&  pins)
+ImOptionalIndex ResolveHoveredLink(const ImNodesEditorContext& editor)
 {
     float           smallest_distance = FLT_MAX;
     ImOptionalIndex link_idx_with_smallest_distance;
@@ -1185,50 +1764,62 @@ ImOptionalIndex ResolveHoveredLink(
     // The latter is a requirement for link detaching with drag click to work, as both a link and
     // pin are required to be hovered over for the feature to work.
 
-    for (int idx = 0; idx < links.Pool.Size; ++idx)
+    ImVector<int>& candidates = GImNodes->SpatialQueryCandidates;
+
+    // If there is a hovered pin links can only be considered hovered if they use that pin. The
+    // bounding rectangle of a link contains both of its pins, so the cell of the pin contains all
+    // of them.
+    if (GImNodes->HoveredPinIdx.HasValue())
     {
-        if (!links.InUse[idx])
+        const int hovered_pin_idx = GImNodes->HoveredPinIdx.Value();
+        SpatialGridQuery(
+            editor.SpatialIndex.Links, editor.Pins.Pool[hovered_pin_idx].GridPos, candidates);
+
+        ImOptionalIndex link_idx_using_pin;
+        for (int i = 0; i < candidates.Size; ++i)
         {
-            continue;
+            const int         idx = candidates[i];
+            const ImLinkData& link = editor.Links.Pool[idx];
+            if (editor.Links.InUse[idx] &&
+                (link.StartPinIdx == hovered_pin_idx || link.EndPinIdx == hovered_pin_idx) &&
+                (!link_idx_using_pin.HasValue() || idx < link_idx_using_pin.Value()))
+            {
+                link_idx_using_pin = idx;
+            }
         }
+        return link_idx_using_pin;
+    }
 
-        const ImLinkData& link = links.Pool[idx];
-        const ImPinData&  start_pin = pins.Pool[link.StartPinIdx];
-        const ImPinData&  end_pin = pins.Pool[link.EndPinIdx];
+    const ImVec2 mouse_pos = ScreenSpaceToGridSpace(editor, GImNodes->MousePos);
+    SpatialGridQuery(editor.SpatialIndex.Links, mouse_pos, candidates);
 
-        // If there is a hovered pin links can only be considered hovered if they use that pin
-        if (GImNodes->HoveredPinIdx.HasValue())
+    for (int i = 0; i < candidates.Size; ++i)
+    {
+        const int idx = candidates[i];
+        if (!editor.Links.InUse[idx])
         {
-            if (GImNodes->HoveredPinIdx == link.StartPinIdx ||
-                GImNodes->HoveredPinIdx == link.EndPinIdx)
-            {
-                return idx;
-            }
             continue;
         }
 
-        // TODO: the calculated CubicBeziers could be cached since we generate them again when
-        // rendering the links
-
-        const CubicBezier cubic_bezier = GetCubicBezier(
-            start_pin.Pos, end_pin.Pos, start_pin.Type, GImNodes->Style.LinkLineSegmentsPerLength);
+        const ImLinkData& link = editor.Links.Pool[idx];
 
         // The distance test
         {
-            const ImRect link_rect = GetContainingRectForCubicBezier(cubic_bezier);
-
             // First, do a simple bounding box test against the box containing the link
             // to see whether calculating the distance to the link is worth doing.
-            if (link_rect.Contains(GImNodes->MousePos))
+            if (link.Geometry.Rect.Contains(mouse_pos))
             {
-                const float distance = GetDistanceToCubicBezier(
-                    GImNodes->MousePos, cubic_bezier, cubic_bezier.NumSegments);
+                const float distance = GetDistanceToPolyline(mouse_pos, link.Geometry.Polyline);
 
                 // TODO: GImNodes->Style.LinkHoverDistance could be also copied into ImLinkData,
                 // since we're not calling this function in the same scope as ImNodes::Link(). The
                 // rendered/detected link might have a different hover distance than what the user
                 // had specified when calling Link()
-                if (distance < GImNodes->Style.LinkHoverDistance && distance < smallest_distance)
+                const bool closer =
+                    distance < smallest_distance ||
+                    (distance == smallest_distance &&
+                     idx < link_idx_with_smallest_distance.Value());
+                if (distance < GImNodes->Style.LinkHoverDistance / editor.Zoom && closer)
                 {
                     smallest_distance = distance;
                     link_idx_with_smallest_distance = idx;
@@ -1244,16 +1835,18 @@ ImOptionalIndex ResolveHoveredLink(
 
 inline ImRect GetItemRect() { return ImRect(ImGui::GetItemRectMin(), ImGui::GetItemRectMax()); }
 
-inline ImVec2 GetNodeTitleBarOrigin(const ImNodeData& node)
+// The layout of the node contents is in editor space, since it is driven by ImGui
+inline ImVec2 GetNodeTitleBarOrigin(const ImNodesEditorContext& editor, const ImNodeData& node)
 {
-    return node.Origin + node.LayoutStyle.Padding;
+    return GridSpaceToEditorSpace(editor, node.Origin) + node.LayoutStyle.Padding;
 }
 
-inline ImVec2 GetNodeContentOrigin(const ImNodeData& node)
+inline ImVec2 GetNodeContentOrigin(const ImNodesEditorContext& editor, const ImNodeData& node)
 {
     const ImVec2 title_bar_height =
         ImVec2(0.f, node.TitleBarContentRect.GetHeight() + 2.0f * node.LayoutStyle.Padding.y);
-    return node.Origin + title_bar_height + node.LayoutStyle.Padding;
+    return GridSpaceToEditorSpace(editor, node.Origin) + title_bar_height +
+           node.LayoutStyle.Padding;
 }
 
 inline ImRect GetNodeTitleRect(const ImNodeData& node)
@@ -1270,9 +1863,9 @@ inline ImRect GetNodeTitleRect(const ImNodeData& node)
 void DrawGrid(ImNodesEditorContext& editor, const ImVec2& canvas_size)
 {
     const ImVec2 offset = editor.Panning;
+    const float  spacing = GImNodes->Style.GridSpacing * editor.Zoom;
 
-    for (float x = fmodf(offset.x, GImNodes->Style.GridSpacing); x < canvas_size.x;
-         x += GImNodes->Style.GridSpacing)
+    for (float x = fmodf(offset.x, spacing); x < canvas_size.x; x += spacing)
     {
         GImNodes->CanvasDrawList->AddLine(
             EditorSpaceToScreenSpace(ImVec2(x, 0.0f)),
@@ -1280,8 +1873,7 @@ void DrawGrid(ImNodesEditorContext& editor, const ImVec2& canvas_size)
             GImNodes->Style.Colors[ImNodesCol_GridLine]);
     }
 
-    for (float y = fmodf(offset.y, GImNodes->Style.GridSpacing); y < canvas_size.y;
-         y += GImNodes->Style.GridSpacing)
+    for (float y = fmodf(offset.y, spacing); y < canvas_size.y; y += spacing)
     {
         GImNodes->CanvasDrawList->AddLine(
             EditorSpaceToScreenSpace(ImVec2(0.0f, y)),
@@ -1436,7 +2028,7 @@ void DrawPin(ImNodesEditorContext& editor, const int pin_idx)
 void DrawNode(ImNodesEditorContext& editor, const int node_idx)
 {
     const ImNodeData& node = editor.Nodes.Pool[node_idx];
-    ImGui::SetCursorPos(node.Origin + editor.Panning);
+    ImGui::SetCursorPos(GridSpaceToEditorSpace(editor, node.Origin));
 
     const bool node_hovered =
         GImNodes->HoveredNodeIdx == node_idx &&
@@ -1520,11 +2112,6 @@ void DrawNode(ImNodesEditorContext& editor, const int node_idx)
 void DrawLink(ImNodesEditorContext& editor, const int link_idx)
 {
     const ImLinkData& link = editor.Links.Pool[link_idx];
-    const ImPinData&  start_pin = editor.Pins.Pool[link.StartPinIdx];
-    const ImPinData&  end_pin = editor.Pins.Pool[link.EndPinIdx];
-
-    const CubicBezier cubic_bezier = GetCubicBezier(
-        start_pin.Pos, end_pin.Pos, start_pin.Type, GImNodes->Style.LinkLineSegmentsPerLength);
 
     const bool link_hovered =
         GImNodes->HoveredLinkIdx == link_idx &&
@@ -1555,18 +2142,24 @@ void DrawLink(ImNodesEditorContext& editor, const int link_idx)
         link_color = link.ColorStyle.Hovered;
     }
 
-#if IMGUI_VERSION_NUM < 18000
-    GImNodes->CanvasDrawList->AddBezierCurve(
-#else
-    GImNodes->CanvasDrawList->AddBezierCubic(
-#endif
-        cubic_bezier.P0,
-        cubic_bezier.P1,
-        cubic_bezier.P2,
-        cubic_bezier.P3,
-        link_color,
-        GImNodes->Style.LinkThickness,
-        cubic_bezier.NumSegments);
+    // The cached polyline is in grid space, and only needs to be scaled and translated onto the
+    // screen
+    const ImVector<ImVec2>& polyline = link.Geometry.Polyline;
+    const ImVec2            offset = GridSpaceToScreenSpace(editor, ImVec2(0.f, 0.f));
+    const float             zoom = editor.Zoom;
+
+    const ImRect link_rect(
+        link.Geometry.Rect.Min * zoom + offset, link.Geometry.Rect.Max * zoom + offset);
+    if (!GImNodes->CanvasRectScreenSpace.Overlaps(link_rect))
+    {
+        return;
+    }
+
+    for (int i = 0; i < polyline.Size; ++i)
+    {
+        GImNodes->CanvasDrawList->PathLineTo(polyline[i] * zoom + offset);
+    }
+    GImNodes->CanvasDrawList->PathStroke(link_color, 0, GImNodes->Style.LinkThickness);
 }
 
 void BeginPinAttribute(
@@ -1762,14 +2355,6 @@ static void MiniMapDrawNode(ImNodesEditorContext& editor, const int node_idx)
 static void MiniMapDrawLink(ImNodesEditorContext& editor, const int link_idx)
 {
     const ImLinkData& link = editor.Links.Pool[link_idx];
-    const ImPinData&  start_pin = editor.Pins.Pool[link.StartPinIdx];
-    const ImPinData&  end_pin = editor.Pins.Pool[link.EndPinIdx];
-
-    const CubicBezier cubic_bezier = GetCubicBezier(
-        ScreenSpaceToMiniMapSpace(editor, start_pin.Pos),
-        ScreenSpaceToMiniMapSpace(editor, end_pin.Pos),
-        start_pin.Type,
-        GImNodes->Style.LinkLineSegmentsPerLength / editor.MiniMapScaling);
 
     // It's possible for a link to be deleted in begin_link_interaction. A user
     // may detach a link, resulting in the link wire snapping to the mouse
@@ -1786,18 +2371,15 @@ static void MiniMapDrawLink(ImNodesEditorContext& editor, const int link_idx)
             [editor.SelectedLinkIndices.contains(link_idx) ? ImNodesCol_MiniMapLinkSelected
                                                            : ImNodesCol_MiniMapLink];
 
-#if IMGUI_VERSION_NUM < 18000
-    GImNodes->CanvasDrawList->AddBezierCurve(
-#else
-    GImNodes->CanvasDrawList->AddBezierCubic(
-#endif
-        cubic_bezier.P0,
-        cubic_bezier.P1,
-        cubic_bezier.P2,
-        cubic_bezier.P3,
-        link_color,
-        GImNodes->Style.LinkThickness * editor.MiniMapScaling,
-        cubic_bezier.NumSegments);
+    // The link is scaled down together with its segment length, so the full-size polyline has
+    // exactly the number of segments the mini-map needs.
+    const ImVector<ImVec2>& polyline = link.Geometry.Polyline;
+    for (int i = 0; i < polyline.Size; ++i)
+    {
+        GImNodes->CanvasDrawList->PathLineTo(GridSpaceToMiniMapSpace(editor, polyline[i]));
+    }
+    GImNodes->CanvasDrawList->PathStroke(
+        link_color, 0, GImNodes->Style.LinkThickness * editor.MiniMapScaling);
 }
 
 static void MiniMapUpdate()
@@ -1874,7 +2456,7 @@ static void MiniMapUpdate()
     {
         ImVec2 target = MiniMapSpaceToGridSpace(editor, ImGui::GetMousePos());
         ImVec2 center = GImNodes->CanvasRectScreenSpace.GetSize() * 0.5f;
-        editor.Panning = ImFloor(center - target);
+        editor.Panning = ImFloor(center - target * editor.Zoom);
     }
 
     // Reset callback info after use
@@ -1923,7 +2505,8 @@ ImNodesIO::LinkDetachWithModifierClick::LinkDetachWithModifierClick() : Modifier
 
 ImNodesIO::ImNodesIO()
     : EmulateThreeButtonMouse(), LinkDetachWithModifierClick(),
-      AltMouseButton(ImGuiMouseButton_Middle), AutoPanningSpeed(1000.0f)
+      AltMouseButton(ImGuiMouseButton_Middle), AutoPanningSpeed(1000.0f), ZoomMin(0.1f),
+      ZoomMax(1.f)
 {
 }
 
@@ -1994,8 +2577,21 @@ void EditorContextMoveToNode(const int node_id)
     ImNodesEditorContext& editor = EditorContextGet();
     ImNodeData&           node = ObjectPoolFindOrCreateObject(editor.Nodes, node_id);
 
-    editor.Panning.x = -node.Origin.x;
-    editor.Panning.y = -node.Origin.y;
+    editor.Panning.x = -node.Origin.x * editor.Zoom;
+    editor.Panning.y = -node.Origin.y * editor.Zoom;
+}
+
+float EditorContextGetZoom()
+{
+    const ImNodesEditorContext& editor = EditorContextGet();
+    return editor.Zoom;
+}
+
+void EditorContextSetZoom(const float zoom)
+{
+    assert(zoom > 0.f);
+    ImNodesEditorContext& editor = EditorContextGet();
+    ZoomAroundScreenSpacePoint(editor, zoom, GImNodes->CanvasRectScreenSpace.GetCenter());
 }
 
 void SetImGuiContext(ImGuiContext* ctx) { ImGui::SetCurrentContext(ctx); }
@@ -2174,6 +2770,9 @@ void BeginNodeEditor()
                 ImGuiWindowFlags_NoScrollWithMouse);
         GImNodes->CanvasOriginScreenSpace = ImGui::GetCursorScreenPos();
 
+        // Node contents are scaled together with grid space
+        ImGui::SetWindowFontScale(editor.Zoom);
+
         // NOTE: we have to fetch the canvas draw list *after* we call
         // BeginChild(), otherwise the ImGui UI elements are going to be
         // rendered into the parent window draw list.
@@ -2205,6 +2804,10 @@ void EndNodeEditor()
         editor.GridContentBounds = ScreenSpaceToGridSpace(editor, GImNodes->CanvasRectScreenSpace);
     }
 
+    // Node rects are final at this point, so the link geometry used for hovering, drawing and box
+    // selection, and the spatial index, can be brought up to date.
+    EditorGeometryUpdate(editor);
+
     // Detect ImGui interaction first, because it blocks interaction with the rest of the UI
 
     if (GImNodes->LeftMouseClicked && ImGui::IsAnyItemActive())
@@ -2223,29 +2826,30 @@ void EndNodeEditor()
          editor.ClickInteraction.Type == ImNodesClickInteractionType_LinkCreation) &&
         MouseInCanvas() && !IsMiniMapHovered())
     {
+        // Hover queries go through the spatial index, brought up to date by EditorGeometryUpdate().
+        UpdateNodeDepthLookup(editor, GImNodes->NodeIdxToDepthIdx);
+
         // Pins needs some special care. We need to check the depth stack to see which pins are
         // being occluded by other nodes.
-        ResolveOccludedPins(editor, GImNodes->OccludedPinIndices);
-
-        GImNodes->HoveredPinIdx = ResolveHoveredPin(editor.Pins, GImNodes->OccludedPinIndices);
+        GImNodes->HoveredPinIdx = ResolveHoveredPin(editor, GImNodes->NodeIdxToDepthIdx);
 
         if (!GImNodes->HoveredPinIdx.HasValue())
         {
             // Resolve which node is actually on top and being hovered using the depth stack.
-            GImNodes->HoveredNodeIdx = ResolveHoveredNode(editor.NodeDepthOrder);
+            GImNodes->HoveredNodeIdx = ResolveHoveredNode(GImNodes->NodeIdxToDepthIdx);
         }
 
         // We don't check for hovered pins here, because if we want to detach a link by clicking and
         // dragging, we need to have both a link and pin hovered.
         if (!GImNodes->HoveredNodeIdx.HasValue())
         {
-            GImNodes->HoveredLinkIdx = ResolveHoveredLink(editor.Links, editor.Pins);
+            GImNodes->HoveredLinkIdx = ResolveHoveredLink(editor);
         }
     }
 
     for (int node_idx = 0; node_idx < editor.Nodes.Pool.size(); ++node_idx)
     {
-        if (editor.Nodes.InUse[node_idx])
+        if (editor.Nodes.InUse[node_idx] && !editor.Nodes.Pool[node_idx].Placeholder)
         {
             DrawListActivateNodeBackground(node_idx);
             DrawNode(editor, node_idx);
@@ -2280,6 +2884,18 @@ void EndNodeEditor()
 
     if (!IsMiniMapHovered())
     {
+        // Zooming doesn't interfere with any of the interactions below, so it's also allowed
+        // while hovering nodes
+        if (GImNodes->AltMouseScrollDelta != 0.f && MouseInCanvas() &&
+            editor.ClickInteraction.Type == ImNodesClickInteractionType_None)
+        {
+            const float zoom = ImClamp(
+                editor.Zoom * powf(MOUSE_WHEEL_ZOOM_STEP, GImNodes->AltMouseScrollDelta),
+                GImNodes->Io.ZoomMin,
+                GImNodes->Io.ZoomMax);
+            ZoomAroundScreenSpacePoint(editor, zoom, GImNodes->MousePos);
+        }
+
         if (GImNodes->LeftMouseClicked && GImNodes->HoveredLinkIdx.HasValue())
         {
             BeginLinkInteraction(editor, GImNodes->HoveredLinkIdx.Value(), GImNodes->HoveredPinIdx);
@@ -2382,6 +2998,8 @@ void BeginNode(const int node_id)
     GImNodes->CurrentNodeIdx = node_idx;
 
     ImNodeData& node = editor.Nodes.Pool[node_idx];
+    node.PinIndices.clear();
+    node.Placeholder = false;
     node.ColorStyle.Background = GImNodes->Style.Colors[ImNodesCol_NodeBackground];
     node.ColorStyle.BackgroundHovered = GImNodes->Style.Colors[ImNodesCol_NodeBackgroundHovered];
     node.ColorStyle.BackgroundSelected = GImNodes->Style.Colors[ImNodesCol_NodeBackgroundSelected];
@@ -2389,14 +3007,14 @@ void BeginNode(const int node_id)
     node.ColorStyle.Titlebar = GImNodes->Style.Colors[ImNodesCol_TitleBar];
     node.ColorStyle.TitlebarHovered = GImNodes->Style.Colors[ImNodesCol_TitleBarHovered];
     node.ColorStyle.TitlebarSelected = GImNodes->Style.Colors[ImNodesCol_TitleBarSelected];
-    node.LayoutStyle.CornerRounding = GImNodes->Style.NodeCornerRounding;
-    node.LayoutStyle.Padding = GImNodes->Style.NodePadding;
+    node.LayoutStyle.CornerRounding = GImNodes->Style.NodeCornerRounding * editor.Zoom;
+    node.LayoutStyle.Padding = GImNodes->Style.NodePadding * editor.Zoom;
     node.LayoutStyle.BorderThickness = GImNodes->Style.NodeBorderThickness;
 
     // ImGui::SetCursorPos sets the cursor position, local to the current widget
     // (in this case, the child object started in BeginNodeEditor). Use
     // ImGui::SetCursorScreenPos to set the screen space coordinates directly.
-    ImGui::SetCursorPos(GridSpaceToEditorSpace(editor, GetNodeTitleBarOrigin(node)));
+    ImGui::SetCursorPos(GetNodeTitleBarOrigin(editor, node));
 
     DrawListAddNode(node_idx);
     DrawListActivateCurrentNodeForeground();
@@ -2421,7 +3039,8 @@ void EndNode()
     node.Rect.Expand(node.LayoutStyle.Padding);
 
     editor.GridContentBounds.Add(node.Origin);
-    editor.GridContentBounds.Add(node.Origin + node.Rect.GetSize());
+    editor.GridContentBounds.Add(node.Origin + node.Rect.GetSize() / editor.Zoom);
+    NodeGeometryUpdate(editor, GImNodes->CurrentNodeIdx);
 
     if (node.Rect.Contains(GImNodes->MousePos))
     {
@@ -2438,6 +3057,75 @@ ImVec2 GetNodeDimensions(int node_id)
     return node.Rect.GetSize();
 }
 
+bool IsNodeOnCanvas(const int node_id)
+{
+    assert(GImNodes->CurrentScope == ImNodesScope_Editor);
+
+    const ImNodesEditorContext& editor = EditorContextGet();
+    const int                   node_idx = ObjectPoolFind(editor.Nodes, node_id);
+    if (node_idx == -1)
+    {
+        return true;
+    }
+
+    const ImNodeData& node = editor.Nodes.Pool[node_idx];
+    const ImVec2      node_size = node.GridRect.GetSize() * editor.Zoom;
+    if (node_size.x <= 0.f || node_size.y <= 0.f)
+    {
+        return true;
+    }
+
+    // Pins are drawn on top of the node's edges, so leave them some room
+    const ImVec2 screen_min = GridSpaceToScreenSpace(editor, node.Origin);
+    ImRect       node_rect(screen_min, screen_min + node_size);
+    node_rect.Expand(GImNodes->Style.PinHoverRadius);
+    return GImNodes->CanvasRectScreenSpace.Overlaps(node_rect);
+}
+
+void NodePlaceholder(const int node_id)
+{
+    assert(GImNodes->CurrentScope == ImNodesScope_Editor);
+
+    ImNodesEditorContext& editor = EditorContextGet();
+
+    // Only a node which was laid out by BeginNode/EndNode before has something to keep alive
+    const int node_idx = ObjectPoolFind(editor.Nodes, node_id);
+    assert(node_idx != -1);
+    editor.Nodes.InUse[node_idx] = true;
+
+    ImNodeData& node = editor.Nodes.Pool[node_idx];
+    node.Placeholder = true;
+
+    // Map last frame's layout to wherever the node is now, at the current zoom
+    const ImVec2 old_min = node.Rect.Min;
+    const ImVec2 new_min = GridSpaceToScreenSpace(editor, node.Origin);
+    const float  old_width = node.Rect.GetWidth();
+    const float  scale = old_width > 0.f ? node.GridRect.GetWidth() * editor.Zoom / old_width : 1.f;
+
+    node.Rect = RemapRect(node.Rect, old_min, new_min, scale);
+    node.TitleBarContentRect = RemapRect(node.TitleBarContentRect, old_min, new_min, scale);
+
+    for (int i = 0; i < node.PinIndices.size(); ++i)
+    {
+        const int  pin_idx = node.PinIndices[i];
+        ImPinData& pin = editor.Pins.Pool[pin_idx];
+        editor.Pins.InUse[pin_idx] = true;
+        pin.AttributeRect = RemapRect(pin.AttributeRect, old_min, new_min, scale);
+        pin.Pos = GetScreenSpacePinCoordinates(node.Rect, pin.AttributeRect, pin.Type);
+    }
+
+    DrawListAddNode(node_idx);
+
+    editor.GridContentBounds.Add(node.Origin);
+    editor.GridContentBounds.Add(node.Origin + node.Rect.GetSize() / editor.Zoom);
+    PlaceholderGeometryUpdate(editor, node_idx);
+
+    if (node.Rect.Contains(GImNodes->MousePos))
+    {
+        GImNodes->NodeIndicesOverlappingWithMouse.push_back(node_idx);
+    }
+}
+
 void BeginNodeTitleBar()
 {
     assert(GImNodes->CurrentScope == ImNodesScope_Node);
@@ -2455,7 +3143,7 @@ void EndNodeTitleBar()
 
     ImGui::ItemAdd(GetNodeTitleRect(node), ImGui::GetID("title_bar"));
 
-    ImGui::SetCursorPos(GridSpaceToEditorSpace(editor, GetNodeContentOrigin(node)));
+    ImGui::SetCursorPos(GetNodeContentOrigin(editor, node));
 }
 
 void BeginInputAttribute(const int id, const ImNodesPinShape shape)
@@ -2521,10 +3209,22 @@ void Link(const int id, const int start_attr_id, const int end_attr_id)
     assert(GImNodes->CurrentScope == ImNodesScope_Editor);
 
     ImNodesEditorContext& editor = EditorContextGet();
-    ImLinkData&           link = ObjectPoolFindOrCreateObject(editor.Links, id);
+    const int             link_idx = ObjectPoolFindOrCreateIndex(editor.Links, id);
+    ImLinkData&           link = editor.Links.Pool[link_idx];
     link.Id = id;
     link.StartPinIdx = ObjectPoolFindOrCreateIndex(editor.Pins, start_attr_id);
     link.EndPinIdx = ObjectPoolFindOrCreateIndex(editor.Pins, end_attr_id);
+
+    // A new link, or one connected to different pins, changes the links of its pins
+    ImSpatialIndex& index = editor.SpatialIndex;
+    if (link.StartPinIdx != link.Geometry.StartPinIdx || link.EndPinIdx != link.Geometry.EndPinIdx)
+    {
+        link.Geometry.StartPinIdx = link.StartPinIdx;
+        link.Geometry.EndPinIdx = link.EndPinIdx;
+        index.ChangedLinks.push_back(link_idx);
+        index.LinksReconnected = true;
+    }
+    ++index.NumSubmittedLinks;
     link.ColorStyle.Base = GImNodes->Style.Colors[ImNodesCol_Link];
     link.ColorStyle.Hovered = GImNodes->Style.Colors[ImNodesCol_LinkHovered];
     link.ColorStyle.Selected = GImNodes->Style.Colors[ImNodesCol_LinkSelected];
@@ -3010,27 +3710,130 @@ bool IsLinkDestroyed(int* const link_id)
 
 namespace
 {
-void NodeLineHandler(ImNodesEditorContext& editor, const char* const line)
+// Editor state is written and read for every node at once, hence these avoid sscanf/appendf and copying the
+// input. Numbers are decimal integers, anything else falls back to strtof.
+
+// Writes value at the end of buf, returns the start of the written digits
+char* IniFormatInt(int value, char* const buf_end)
 {
-    int id;
-    int x, y;
-    if (sscanf(line, "[node.%i", &id) == 1)
+    char*              cursor = buf_end;
+    const bool         negative = value < 0;
+    unsigned long long magnitude = negative ? 0ull - (unsigned long long)value : (unsigned long long)value;
+    do
     {
-        const int node_idx = ObjectPoolFindOrCreateIndex(editor.Nodes, id);
-        GImNodes->CurrentNodeIdx = node_idx;
-        ImNodeData& node = editor.Nodes.Pool[node_idx];
-        node.Id = id;
+        *--cursor = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (negative)
+    {
+        *--cursor = '-';
     }
-    else if (sscanf(line, "origin=%i,%i", &x, &y) == 2)
+    return cursor;
+}
+
+char* IniAppend(char* out, const char* str)
+{
+    while (*str != '\0')
     {
-        ImNodeData& node = editor.Nodes.Pool[GImNodes->CurrentNodeIdx];
-        node.Origin = ImVec2((float)x, (float)y);
+        *out++ = *str++;
     }
+    return out;
 }
 
-void EditorLineHandler(ImNodesEditorContext& editor, const char* const line)
+char* IniAppendInt(char* const out, const int value)
 {
-    (void)sscanf(line, "panning=%f,%f", &editor.Panning.x, &editor.Panning.y);
+    char        digits[16];
+    const char* digits_end = digits + sizeof(digits);
+    const char* digits_begin = IniFormatInt(value, digits + sizeof(digits));
+    const int   count = (int)(digits_end - digits_begin);
+    memcpy(out, digits_begin, count);
+    return out + count;
+}
+
+bool IniConsume(const char*& cursor, const char* const end, const char* const literal)
+{
+    const size_t length = strlen(literal);
+    if ((size_t)(end - cursor) < length || memcmp(cursor, literal, length) != 0)
+    {
+        return false;
+    }
+    cursor += length;
+    return true;
+}
+
+bool IniParseInt(const char*& cursor, const char* const end, int& value)
+{
+    const char* it = cursor;
+    const bool  negative = it < end && *it == '-';
+    if (it < end && (*it == '-' || *it == '+'))
+    {
+        ++it;
+    }
+    if (it == end || *it < '0' || *it > '9')
+    {
+        return false;
+    }
+    long long magnitude = 0;
+    for (; it < end && *it >= '0' && *it <= '9'; ++it)
+    {
+        magnitude = magnitude * 10 + (*it - '0');
+        if (magnitude > (long long)INT_MAX + 1)
+        {
+            return false;
+        }
+    }
+    if (!negative && magnitude > INT_MAX)
+    {
+        return false;
+    }
+    value = (int)(negative ? -magnitude : magnitude);
+    cursor = it;
+    return true;
+}
+
+bool IniParseFloat(const char*& cursor, const char* const end, float& value)
+{
+    // Integer fast path, for values written by SaveEditorStateToIniString
+    const char* it = cursor;
+    int         int_value;
+    if (IniParseInt(it, end, int_value) && (it == end || (*it != '.' && *it != 'e' && *it != 'E')))
+    {
+        value = (float)int_value;
+        cursor = it;
+        return true;
+    }
+
+    // input is not null terminated, copy the token for strtof
+    char   token[64];
+    size_t length = 0;
+    while (cursor + length < end && length + 1 < sizeof(token) && cursor[length] != ',' &&
+           cursor[length] != '\n' && cursor[length] != '\r')
+    {
+        token[length] = cursor[length];
+        ++length;
+    }
+    token[length] = '\0';
+    char*       token_end = NULL;
+    const float parsed = strtof(token, &token_end);
+    if (token_end == token)
+    {
+        return false;
+    }
+    value = parsed;
+    cursor += token_end - token;
+    return true;
+}
+
+bool IniParseVec2(const char*& cursor, const char* const end, ImVec2& value)
+{
+    ImVec2 parsed;
+    if (!IniParseFloat(cursor, end, parsed.x) || !IniConsume(cursor, end, ",") ||
+        !IniParseFloat(cursor, end, parsed.y))
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
 }
 } // namespace
 
@@ -3046,20 +3849,34 @@ const char* SaveEditorStateToIniString(
     assert(editor_ptr != NULL);
     const ImNodesEditorContext& editor = *editor_ptr;
 
+    // Longest node entry is "\n[node.-2147483648]\norigin=-2147483648,-2147483648\n"
+    const int max_entry_size = 64;
+    char      entry[max_entry_size];
+
     GImNodes->TextBuffer.clear();
-    // TODO: check to make sure that the estimate is the upper bound of element
-    GImNodes->TextBuffer.reserve(64 * editor.Nodes.Pool.size());
+    GImNodes->TextBuffer.reserve(max_entry_size * (editor.Nodes.Pool.size() + 1));
 
-    GImNodes->TextBuffer.appendf(
-        "[editor]\npanning=%i,%i\n", (int)editor.Panning.x, (int)editor.Panning.y);
+    char* out = IniAppend(entry, "[editor]\npanning=");
+    out = IniAppendInt(out, (int)editor.Panning.x);
+    out = IniAppend(out, ",");
+    out = IniAppendInt(out, (int)editor.Panning.y);
+    out = IniAppend(out, "\n");
+    GImNodes->TextBuffer.append(entry, out);
 
     for (int i = 0; i < editor.Nodes.Pool.size(); i++)
     {
         if (editor.Nodes.InUse[i])
         {
             const ImNodeData& node = editor.Nodes.Pool[i];
-            GImNodes->TextBuffer.appendf("\n[node.%d]\n", node.Id);
-            GImNodes->TextBuffer.appendf("origin=%i,%i\n", (int)node.Origin.x, (int)node.Origin.y);
+            out = IniAppend(entry, "\n[node.");
+            out = IniAppendInt(out, node.Id);
+            out = IniAppend(out, "]\norigin=");
+            out = IniAppendInt(out, (int)node.Origin.x);
+            out = IniAppend(out, ",");
+            out = IniAppendInt(out, (int)node.Origin.y);
+            out = IniAppend(out, "\n");
+            assert(out - entry <= max_entry_size);
+            GImNodes->TextBuffer.append(entry, out);
         }
     }
 
@@ -3088,51 +3905,67 @@ void LoadEditorStateFromIniString(
 
     ImNodesEditorContext& editor = editor_ptr == NULL ? EditorContextGet() : *editor_ptr;
 
-    char*       buf = (char*)ImGui::MemAlloc(data_size + 1);
-    const char* buf_end = buf + data_size;
-    memcpy(buf, data, data_size);
-    buf[data_size] = 0;
-
-    void (*line_handler)(ImNodesEditorContext&, const char*);
-    line_handler = NULL;
-    char* line_end = NULL;
-    for (char* line = buf; line < buf_end; line = line_end + 1)
+    enum Section
+    {
+        Section_None,
+        Section_Editor,
+        Section_Node
+    };
+    Section     section = Section_None;
+    int         node_idx = -1;
+    const char* data_end = data + data_size;
+    for (const char* line = data; line < data_end;)
     {
-        while (*line == '\n' || *line == '\r')
+        const char* line_end = (const char*)memchr(line, '\n', data_end - line);
+        if (line_end == NULL)
         {
-            line++;
+            line_end = data_end;
         }
-        line_end = line;
-        while (line_end < buf_end && *line_end != '\n' && *line_end != '\r')
+        const char* next_line = line_end + 1;
+        if (line_end > line && line_end[-1] == '\r')
         {
-            line_end++;
+            --line_end;
         }
-        line_end[0] = 0;
 
-        if (*line == ';' || *line == '\0')
+        if (line == line_end || *line == ';')
         {
-            continue;
+            // empty line or comment
         }
-
-        if (line[0] == '[' && line_end[-1] == ']')
+        else if (line[0] == '[' && line_end[-1] == ']')
         {
-            line_end[-1] = 0;
-            if (strncmp(line + 1, "node", 4) == 0)
+            const char* cursor = line + 1;
+            int         id;
+            if (IniConsume(cursor, line_end, "node.") && IniParseInt(cursor, line_end, id) &&
+                cursor == line_end - 1)
             {
-                line_handler = NodeLineHandler;
+                section = Section_Node;
+                node_idx = ObjectPoolFindOrCreateIndex(editor.Nodes, id);
+                editor.Nodes.Pool[node_idx].Id = id;
             }
-            else if (strcmp(line + 1, "editor") == 0)
+            else if (IniConsume(cursor = line + 1, line_end, "editor]") && cursor == line_end)
+            {
+                section = Section_Editor;
+            }
+            else
             {
-                line_handler = EditorLineHandler;
+                section = Section_None;
             }
         }
-
-        if (line_handler != NULL)
+        else
         {
-            line_handler(editor, line);
+            const char* cursor = line;
+            if (section == Section_Node && IniConsume(cursor, line_end, "origin="))
+            {
+                IniParseVec2(cursor, line_end, editor.Nodes.Pool[node_idx].Origin);
+            }
+            else if (section == Section_Editor && IniConsume(cursor, line_end, "panning="))
+            {
+                IniParseVec2(cursor, line_end, editor.Panning);
+            }
         }
+
+        line = next_line;
     }
-    ImGui::MemFree(buf);
 }
 
 void SaveCurrentEditorStateToIniFile(const char* const file_name)
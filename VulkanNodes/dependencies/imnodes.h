@@ -141,6 +141,10 @@ struct ImNodesIO
     // Panning speed when dragging an element and mouse is outside the main editor view.
     float AutoPanningSpeed;
 
+    // Range of the canvas zoom factor which the mouse wheel moves through. Setting both to 1
+    // disables zooming with the mouse wheel.
+    float ZoomMin, ZoomMax;
+
     ImNodesIO();
 };
 
@@ -236,6 +240,11 @@ void                  EditorContextSet(ImNodesEditorContext*);
 ImVec2                EditorContextGetPanning();
 void                  EditorContextResetPanning(const ImVec2& pos);
 void                  EditorContextMoveToNode(const int node_id);
+// The zoom factor scales grid space onto the canvas. Node contents are drawn with a matching ImGui
+// font scale, so the UI inside of nodes should scale any fixed widths it uses by it as well.
+float                 EditorContextGetZoom();
+// Zoom around the center of the canvas
+void                  EditorContextSetZoom(float zoom);
 
 ImNodesIO& GetIO();
 
@@ -272,6 +281,14 @@ void EndNode();
 
 ImVec2 GetNodeDimensions(int id);
 
+// Returns true if the node overlaps the editor canvas, given its current position and the size it
+// had the last time it was submitted. Nodes which were never submitted count as visible.
+bool IsNodeOnCanvas(int id);
+// Submit a node which is not on the canvas in place of BeginNode/EndNode. The node and its pins
+// stay alive with the layout they had the last time the node was submitted, but no UI is created
+// and nothing is rendered for it.
+void NodePlaceholder(int id);
+
 // Place your node title bar content (such as the node title, using ImGui::Text) between the
 // following function calls. These functions have to be called before adding any attributes, or the
 // layout of the node will be incorrect.
@@ -316,7 +333,8 @@ void SetNodeDraggable(int node_id, const bool draggable);
 // * editor space coordinates -- the origin is the upper left corner of the node editor window
 // * grid space coordinates, -- the origin is the upper left corner of the node editor window,
 // translated by the current editor panning vector (see EditorContextGetPanning() and
-// EditorContextResetPanning())
+// EditorContextResetPanning()), and divided by the current zoom factor (see
+// EditorContextGetZoom())
 
 // Use the following functions to get and set the node's coordinates in these coordinate systems.
 
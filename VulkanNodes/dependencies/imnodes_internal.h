@@ -151,11 +151,17 @@ struct ImNodeData
 
     ImVector<int> PinIndices;
     bool          Draggable;
+    bool          Placeholder; // submitted via NodePlaceholder() this frame
+
+    // Grid-space copy of Rect, as it was inserted into the editor's spatial index, and the origin
+    // of the node at the time. A placeholder node only moves by the difference of the origins.
+    ImRect GridRect;
+    ImVec2 GridOrigin;
 
     ImNodeData(const int node_id)
         : Id(node_id), Origin(100.0f, 100.0f), TitleBarContentRect(),
           Rect(ImVec2(0.0f, 0.0f), ImVec2(0.0f, 0.0f)), ColorStyle(), LayoutStyle(), PinIndices(),
-          Draggable(true)
+          Draggable(true), Placeholder(false), GridRect(), GridOrigin()
     {
     }
 
@@ -169,7 +175,8 @@ struct ImPinData
     ImRect               AttributeRect;
     ImNodesAttributeType Type;
     ImNodesPinShape      Shape;
-    ImVec2               Pos; // screen-space coordinates
+    ImVec2               Pos;     // screen-space coordinates
+    ImVec2               GridPos; // grid-space coordinates, as inserted into the spatial index
     int                  Flags;
 
     struct
@@ -179,12 +186,18 @@ struct ImPinData
 
     ImPinData(const int pin_id)
         : Id(pin_id), ParentNodeIdx(), AttributeRect(), Type(ImNodesAttributeType_None),
-          Shape(ImNodesPinShape_CircleFilled), Pos(), Flags(ImNodesAttributeFlags_None),
+          Shape(ImNodesPinShape_CircleFilled), Pos(), GridPos(), Flags(ImNodesAttributeFlags_None),
           ColorStyle()
     {
     }
 };
 
+struct ImCubicBezier
+{
+    ImVec2 P0, P1, P2, P3;
+    int    NumSegments;
+};
+
 struct ImLinkData
 {
     int Id;
@@ -195,7 +208,101 @@ struct ImLinkData
         ImU32 Base, Hovered, Selected;
     } ColorStyle;
 
-    ImLinkData(const int link_id) : Id(link_id), StartPinIdx(), EndPinIdx(), ColorStyle() {}
+    // Grid-space geometry of the link, shared by hovering, rendering and box selection. It is only
+    // regenerated when one of the values it was generated from changes.
+    struct
+    {
+        int                  StartPinIdx, EndPinIdx; // pins of the link as of its last submission
+        ImVec2               StartPos, EndPos;
+        ImNodesAttributeType StartType;
+        float                LineSegmentsPerLength, HoverDistance;
+
+        ImCubicBezier    Bezier;
+        ImRect           Rect;     // contains the curve, expanded by HoverDistance (in grid space)
+        ImVector<ImVec2> Polyline; // Bezier.NumSegments + 1 points along the curve
+    } Geometry;
+
+    ImLinkData(const int link_id)
+        : Id(link_id), StartPinIdx(), EndPinIdx(), ColorStyle(), Geometry()
+    {
+        Geometry.StartPinIdx = -1;
+        Geometry.EndPinIdx = -1;
+    }
+};
+
+// Entry of an object in one cell of an ImSpatialGrid. It is linked into the list of its cell and
+// into the list of entries of its object, so that an object can be removed without a search.
+struct ImSpatialGridEntry
+{
+    int ObjectIdx;
+    int Cell;
+    int PrevInCell, NextInCell;
+    int NextOfObject;
+};
+
+// Cells an object of an ImSpatialGrid is in, -1 in FirstEntry if the object is not in the grid
+struct ImSpatialGridObject
+{
+    int  X0, Y0, X1, Y1;
+    int  FirstEntry;
+    bool Oversized;
+};
+
+// Uniform grid over grid-space rectangles, updated in place as objects are inserted, moved and
+// removed. An object index is stored in every cell its rectangle overlaps, so that a point query
+// only visits a single cell. Objects which would cover too many cells are kept in Oversized instead,
+// and are returned by every query.
+struct ImSpatialGrid
+{
+    ImRect Bounds;
+    float  CellSize;
+    int    Width, Height;
+
+    ImVector<int>                 CellHeads; // first entry of each cell, -1 if the cell is empty
+    ImVector<ImSpatialGridEntry>  Entries;
+    int                           FreeEntry; // unused entries are chained through NextInCell
+    ImVector<ImSpatialGridObject> Objects;   // indexed by object index
+    ImVector<int>                 Oversized;
+    int                           NumObjects;
+
+    ImSpatialGrid()
+        : Bounds(), CellSize(0.f), Width(0), Height(0), CellHeads(), Entries(), FreeEntry(-1),
+          Objects(), Oversized(), NumObjects(0)
+    {
+    }
+};
+
+// Acceleration structure for hover queries. Nodes and links record their grid-space geometry
+// changes while they are submitted, and only those objects are moved in the grids in
+// EndNodeEditor(). The grids are rebuilt from scratch only when the node pool grew, a node left
+// the grid bounds, or the zoom changed the hover distances.
+struct ImSpatialIndex
+{
+    ImSpatialGrid Nodes;
+    ImSpatialGrid Pins;
+    ImSpatialGrid Links;
+
+    // Object indices whose grid-space geometry changed this frame. May contain duplicates.
+    ImVector<int> ChangedNodes, ChangedPins, ChangedLinks;
+    // Links attached to each pin, PinLinks[PinLinkStart[pin_idx], PinLinkStart[pin_idx + 1]).
+    // Rebuilt when a link was added or connected to different pins.
+    ImVector<int> PinLinkStart, PinLinks;
+    bool          LinksReconnected;
+
+    // Objects submitted this frame, and links submitted in the previous frame
+    int NumSubmittedNodes, NumSubmittedPins, NumSubmittedLinks, NumPreviousLinks;
+    // Grid-space hover distances and link tessellation the grids were built with
+    float PinHoverRadius, LinkHoverDistance, LinkLineSegmentsPerLength;
+    // Size of the node pool at the last rebuild, -1 if the grids were never built
+    int NodeCapacity;
+
+    ImSpatialIndex()
+        : Nodes(), Pins(), Links(), ChangedNodes(), ChangedPins(), ChangedLinks(), PinLinkStart(),
+          PinLinks(), LinksReconnected(true), NumSubmittedNodes(0), NumSubmittedPins(0),
+          NumSubmittedLinks(0), NumPreviousLinks(0), PinHoverRadius(0.f), LinkHoverDistance(0.f),
+          LinkLineSegmentsPerLength(0.f), NodeCapacity(-1)
+    {
+    }
 };
 
 struct ImClickInteractionState
@@ -252,9 +359,13 @@ struct ImNodesEditorContext
 
     ImVector<int> NodeDepthOrder;
 
+    ImSpatialIndex SpatialIndex;
+
     // ui related fields
     ImVec2 Panning;
     ImVec2 AutoPanningDelta;
+    // Grid space is scaled by this factor on the canvas
+    float Zoom;
     // Minimum and maximum extents of all content in grid space. Valid after final
     // ImNodes::EndNode() call.
     ImRect GridContentBounds;
@@ -279,8 +390,9 @@ struct ImNodesEditorContext
     float  MiniMapScaling;
 
     ImNodesEditorContext()
-        : Nodes(), Pins(), Links(), Panning(0.f, 0.f), SelectedNodeIndices(), SelectedLinkIndices(),
-          ClickInteraction(), MiniMapEnabled(false), MiniMapSizeFraction(0.0f),
+        : Nodes(), Pins(), Links(), SpatialIndex(), Panning(0.f, 0.f), Zoom(1.f),
+          SelectedNodeIndices(), SelectedLinkIndices(), ClickInteraction(), MiniMapEnabled(false),
+          MiniMapSizeFraction(0.0f),
           MiniMapNodeHoveringCallback(NULL), MiniMapNodeHoveringCallbackUserData(NULL),
           MiniMapScaling(0.0f)
     {
@@ -297,7 +409,11 @@ struct ImNodesContext
     ImGuiStorage  NodeIdxToSubmissionIdx;
     ImVector<int> NodeIdxSubmissionOrder;
     ImVector<int> NodeIndicesOverlappingWithMouse;
-    ImVector<int> OccludedPinIndices;
+
+    // Hover resolution scratch state
+    ImVector<int> NodeIdxToDepthIdx;
+    ImVector<int> SpatialQueryCandidates;
+    ImVector<int> SpatialQueryOccluders;
 
     // Canvas extents
     ImVec2 CanvasOriginScreenSpace;
@@ -387,11 +503,7 @@ inline void ObjectPoolUpdate(ImObjectPool<ImNodeData>& nodes)
 {
     for (int i = 0; i < nodes.InUse.size(); ++i)
     {
-        if (nodes.InUse[i])
-        {
-            nodes.Pool[i].PinIndices.clear();
-        }
-        else
+        if (!nodes.InUse[i])
         {
             const int id = nodes.Pool[i].Id;
 